@@ -0,0 +1,53 @@
+#!/bin/sh
+# Check that every SIMD span kernel renders bitwise the same images as the scalar kernel.
+#
+# usage: doc/check_simd_kernels.sh <ply2image> <input.ply> <width> <height> [further ply2image options]
+#
+# The input is rendered with every engine and the raster filters min and none, once per --simd level. Levels that
+# the CPU does not support are skipped. Use an image size at which the triangles span more than 8 pixels, so that
+# the incremental edge stepping of the kernels is covered as well. The exit status is 1 if any output differs.
+
+set -u
+
+if [ $# -lt 4 ]; then
+    echo "usage: $0 <ply2image> <input.ply> <width> <height> [further ply2image options]" >&2
+    exit 2
+fi
+
+program=$1
+input=$2
+width=$3
+height=$4
+shift 4
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+status=0
+for engine in vector csr streaming; do
+    for filter in min none; do
+        name=$engine.$filter
+        if ! "$program" -i "$input" -w "$width" -h "$height" -o "$dir/$name.scalar.bbf" \
+            --engine "$engine" --raster-filter "$filter" --simd scalar "$@" >/dev/null
+        then
+            echo "$name: scalar render failed"
+            status=1
+            continue
+        fi
+
+        for level in sse4.2 avx2 avx512; do
+            if ! "$program" -i "$input" -w "$width" -h "$height" -o "$dir/$name.$level.bbf" \
+                --engine "$engine" --raster-filter "$filter" --simd "$level" "$@" >/dev/null 2>&1
+            then
+                echo "$name: $level skipped, not supported"
+            elif cmp -s "$dir/$name.scalar.bbf" "$dir/$name.$level.bbf"; then
+                echo "$name: $level identical"
+            else
+                echo "$name: $level DIFFERS from scalar"
+                status=1
+            fi
+        done
+    done
+done
+
+exit $status
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "bbf_tile_writer.hpp"
+#include "bitmap_view.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PLY2IMAGE_MAPPED_OUTPUT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+namespace ply2image{
+
+
+    /// \brief How a mapped output file is flushed to disk when it is finished
+    enum class output_sync{
+        /// \brief Leave the write back to the operating system
+        none = 0,
+
+        /// \brief Write the mapped pages back with msync and wait for it
+        msync = 1,
+
+        /// \brief msync and then fdatasync, so the file size is on disk as well
+        fdatasync = 2
+    };
+
+
+    /// \brief BBF image of doubles with one channel whose data section is a shared memory mapping of the file
+    ///
+    /// The file is created with its final size and the header on construction. The renderer writes the pixels
+    /// through view() directly into the page cache, so the image is never copied. Where posix_fallocate exists the
+    /// disk space is reserved up front, a full disk is then reported as error instead of a SIGBUS on first write.
+    /// finish() flushes the file as selected and unmaps it. Only available on POSIX systems.
+    class bbf_mapped_image{
+    public:
+        /// \throw std::system_error if the file can't be created or mapped
+        /// \throw std::runtime_error if the platform has no memory mapped files
+        bbf_mapped_image(std::string const& filename, std::size_t const width, std::size_t const height)
+            : filename_(filename)
+            , width_(width)
+            , height_(height)
+            , size_(bbf_header_size + width * height * sizeof(double))
+        {
+#ifdef PLY2IMAGE_MAPPED_OUTPUT
+            fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+            if(fd_ < 0){
+                throw_error("can't open file");
+            }
+
+#ifdef __linux__
+            if(auto const error = ::posix_fallocate(fd_, 0, static_cast<off_t>(size_)); error != 0){
+                release();
+                throw std::system_error(error, std::generic_category(), "can't reserve space for file " + filename);
+            }
+#else
+            if(::ftruncate(fd_, static_cast<off_t>(size_)) != 0){
+                throw_error("can't resize file");
+            }
+#endif
+
+            auto const map = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if(map == MAP_FAILED){
+                throw_error("can't map file");
+            }
+            map_ = static_cast<char*>(map);
+
+            auto const header = bbf_header(width, height, 1);
+            std::memcpy(map_, header.data(), header.size());
+#else
+            throw std::runtime_error("memory mapped output is not supported on this platform");
+#endif
+        }
+
+        bbf_mapped_image(bbf_mapped_image const&) = delete;
+        bbf_mapped_image& operator=(bbf_mapped_image const&) = delete;
+
+        ~bbf_mapped_image(){
+            release();
+        }
+
+        /// \brief The pixels in the file mapping, valid until finish()
+        bitmap_view view()const noexcept{
+            return {reinterpret_cast<double*>(map_ + bbf_header_size), width_, height_};
+        }
+
+        /// \brief Flush the file as selected by sync and unmap it
+        ///
+        /// \throw std::system_error
+        void finish(output_sync const sync){
+#ifdef PLY2IMAGE_MAPPED_OUTPUT
+            if(sync != output_sync::none && ::msync(map_, size_, MS_SYNC) != 0){
+                throw_error("can't write back mapping of file");
+            }
+
+            if(::munmap(map_, size_) != 0){
+                throw_error("can't unmap file");
+            }
+            map_ = nullptr;
+
+#ifdef __APPLE__
+            // macOS declares no fdatasync
+            if(sync == output_sync::fdatasync && ::fsync(fd_) != 0){
+#else
+            if(sync == output_sync::fdatasync && ::fdatasync(fd_) != 0){
+#endif
+                throw_error("can't sync file");
+            }
+
+            auto const fd = fd_;
+            fd_ = -1;
+            if(::close(fd) != 0){
+                throw std::system_error(errno, std::generic_category(), "can't close file " + filename_);
+            }
+#else
+            static_cast<void>(sync);
+#endif
+        }
+
+    private:
+        /// \brief Unmap and close without error reporting
+        void release()noexcept{
+#ifdef PLY2IMAGE_MAPPED_OUTPUT
+            if(map_ != nullptr){
+                ::munmap(map_, size_);
+                map_ = nullptr;
+            }
+
+            if(fd_ >= 0){
+                ::close(fd_);
+                fd_ = -1;
+            }
+#endif
+        }
+
+        /// \brief Release the file and throw the current errno as std::system_error
+        [[noreturn]] void throw_error(char const* const message){
+            auto const error = errno;
+            release();
+            throw std::system_error(error, std::generic_category(), std::string(message) + " " + filename_);
+        }
+
+        std::string filename_;
+        std::size_t width_;
+        std::size_t height_;
+        std::size_t size_;
+        int fd_ = -1;
+        char* map_ = nullptr;
+    };
+
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "bitmap/bitmap.hpp"
+#include "bitmap/exception.hpp"
+#include "bitmap/detail/binary_io_flags.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Size of the BBF header in bytes
+    inline constexpr std::size_t bbf_header_size = 24;
+
+    /// \brief BBF header of an image of doubles with channel_count channels in native byte order
+    inline std::array<char, bbf_header_size> bbf_header(
+        std::size_t const width,
+        std::size_t const height,
+        std::uint8_t const channel_count
+    ){
+        std::uint8_t const version = 0x00;
+        std::uint8_t const size_in_byte = sizeof(double);
+        std::uint8_t const flags = (bmp::detail::binary_io_flags_v<double> & 0x0F) |
+            std::uint8_t(std::endian::native == std::endian::little
+                ? bmp::detail::binary_endian_flags::is_little_endian
+                : bmp::detail::binary_endian_flags::is_big_endian);
+        std::uint64_t const w_bytes = bmp::detail::byteswap_on_little_endian(std::uint64_t(width));
+        std::uint64_t const h_bytes = bmp::detail::byteswap_on_little_endian(std::uint64_t(height));
+
+        std::array<char, bbf_header_size> header;
+        std::memcpy(header.data(), &bmp::detail::big_endian_io_magic, 4);
+        std::memcpy(header.data() + 4, &version, 1);
+        std::memcpy(header.data() + 5, &size_in_byte, 1);
+        std::memcpy(header.data() + 6, &channel_count, 1);
+        std::memcpy(header.data() + 7, &flags, 1);
+        std::memcpy(header.data() + 8, &w_bytes, 8);
+        std::memcpy(header.data() + 16, &h_bytes, 8);
+        return header;
+    }
+
+    /// \brief Write the BBF header of an image of doubles with channel_count channels in native byte order
+    inline void write_bbf_header(
+        std::ostream& os,
+        std::size_t const width,
+        std::size_t const height,
+        std::uint8_t const channel_count
+    ){
+        auto const header = bbf_header(width, height, channel_count);
+        os.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    /// \brief Write equally sized images of doubles as the channels of one BBF image in native byte order
+    ///
+    /// \throw bmp::binary_io_error
+    inline void write_bbf_channels(std::string const& filename, std::span<bmp::bitmap<double> const* const> channels){
+        if(channels.empty() || channels.size() > 255){
+            throw std::logic_error("a BBF image has 1 to 255 channels");
+        }
+
+        std::ofstream os(filename, std::ios_base::binary | std::ios_base::trunc);
+        if(!os.is_open()){
+            throw bmp::binary_io_error("can't open file: " + filename);
+        }
+
+        auto const w = channels[0]->w();
+        auto const h = channels[0]->h();
+        write_bbf_header(os, w, h, static_cast<std::uint8_t>(channels.size()));
+
+        // channels are interleaved per pixel
+        std::vector<double> row(w * channels.size());
+        for(std::size_t y = 0; y < h; ++y){
+            for(std::size_t x = 0; x < w; ++x){
+                for(std::size_t c = 0; c < channels.size(); ++c){
+                    row[x * channels.size() + c] = (*channels[c])(x, y);
+                }
+            }
+            os.write(reinterpret_cast<char const*>(row.data()),
+                static_cast<std::streamsize>(row.size() * sizeof(double)));
+        }
+
+        if(!os.good()){
+            throw bmp::binary_io_error("can't write binary bitmap format: " + filename);
+        }
+    }
+
+
+    /// \brief Write a BBF image of doubles in native byte order tile by tile
+    ///
+    /// The header is written on construction. Every tile is written independently at its position in the data
+    /// section, the tiles must cover the whole image.
+    class bbf_tile_writer{
+    public:
+        /// \throw bmp::binary_io_error
+        bbf_tile_writer(std::string const& filename, std::size_t const width, std::size_t const height)
+            : filename_(filename)
+            , width_(width)
+            , os_(filename, std::ios_base::binary | std::ios_base::trunc)
+        {
+            if(!os_.is_open()){
+                throw bmp::binary_io_error("can't open file: " + filename);
+            }
+
+            write_bbf_header(os_, width, height, 1);
+            check("can't write binary bitmap format header");
+        }
+
+        /// \brief Write tile with its upper left pixel at (x, y) of the image
+        ///
+        /// \throw bmp::binary_io_error
+        void write(bmp::bitmap<double> const& tile, std::size_t const x, std::size_t const y){
+            for(std::size_t ty = 0; ty < tile.h(); ++ty){
+                os_.seekp(static_cast<std::streamoff>(bbf_header_size + ((y + ty) * width_ + x) * sizeof(double)));
+                os_.write(reinterpret_cast<char const*>(&tile(0, ty)),
+                    static_cast<std::streamsize>(tile.w() * sizeof(double)));
+            }
+            check("can't write binary bitmap format data");
+        }
+
+    private:
+        void check(char const* const message){
+            if(!os_.good()){
+                throw bmp::binary_io_error(std::string(message) + ": " + filename_);
+            }
+        }
+
+        std::string filename_;
+        std::size_t width_;
+        std::ofstream os_;
+    };
+
+
+}
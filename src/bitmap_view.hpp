@@ -0,0 +1,57 @@
+#pragma once
+
+#include "bitmap/bitmap.hpp"
+
+#include <cstddef>
+
+
+namespace ply2image{
+
+
+    /// \brief Non-owning view of a row-major image of doubles, e.g. of a bmp::bitmap<double> or a mapped file
+    class bitmap_view{
+    public:
+        bitmap_view(double* const data, std::size_t const width, std::size_t const height)noexcept
+            : data_(data)
+            , width_(width)
+            , height_(height) {}
+
+        bitmap_view(bmp::bitmap<double>& image)noexcept
+            : bitmap_view(image.data(), image.w(), image.h()) {}
+
+        std::size_t w()const noexcept{
+            return width_;
+        }
+
+        std::size_t h()const noexcept{
+            return height_;
+        }
+
+        std::size_t point_count()const noexcept{
+            return width_ * height_;
+        }
+
+        double* data()const noexcept{
+            return data_;
+        }
+
+        double* begin()const noexcept{
+            return data_;
+        }
+
+        double* end()const noexcept{
+            return data_ + point_count();
+        }
+
+        double& operator()(std::size_t const x, std::size_t const y)const noexcept{
+            return data_[y * width_ + x];
+        }
+
+    private:
+        double* data_;
+        std::size_t width_;
+        std::size_t height_;
+    };
+
+
+}
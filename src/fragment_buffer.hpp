@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Fragments of all pixels of an image in one contiguous array (compressed sparse rows)
+    ///
+    /// The buffer is filled in two passes. First the fragments of every pixel are counted, then allocate()
+    /// computes the pixel offsets by a prefix sum. In the second pass the same fragments are pushed in their final
+    /// order. Afterwards every pixel owns a span of the array, which can be shrunk for filtering.
+    template <typename Fragment>
+    class fragment_buffer{
+    public:
+        fragment_buffer(std::size_t const width, std::size_t const height)
+            : w_(width)
+            , h_(height)
+            , sizes_(width * height) {}
+
+        std::size_t w()const noexcept{
+            return w_;
+        }
+
+        std::size_t h()const noexcept{
+            return h_;
+        }
+
+        std::size_t point_count()const noexcept{
+            return sizes_.size();
+        }
+
+        /// \brief Total count of fragments
+        std::size_t fragment_count()const noexcept{
+            return fragments_.size();
+        }
+
+        /// \brief Count a fragment of pixel (x, y) in the count pass
+        void count(std::size_t const x, std::size_t const y)noexcept{
+            ++sizes_[y * w_ + x];
+        }
+
+        /// \brief Count a fragment of pixel (x, y) in a count pass that runs on several threads
+        void count_concurrent(std::size_t const x, std::size_t const y)noexcept{
+            std::atomic_ref(sizes_[y * w_ + x]).fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// \brief Finish the count pass and allocate the fragment array
+        void allocate(){
+            offsets_.resize(sizes_.size() + 1);
+            offsets_[0] = 0;
+            std::inclusive_scan(sizes_.begin(), sizes_.end(), offsets_.begin() + 1, std::plus<std::size_t>{},
+                std::size_t(0));
+            fragments_.resize(offsets_.back());
+            std::ranges::fill(sizes_, 0);
+        }
+
+        /// \brief Store a fragment of pixel (x, y) in the fill pass
+        void push(std::size_t const x, std::size_t const y, Fragment const& fragment)noexcept{
+            auto const i = y * w_ + x;
+            fragments_[offsets_[i] + sizes_[i]++] = fragment;
+        }
+
+        /// \brief Fragments of the pixel with index i in row-major order
+        std::span<Fragment> operator[](std::size_t const i)noexcept{
+            return {fragments_.data() + offsets_[i], sizes_[i]};
+        }
+
+        /// \brief Fragments of the pixel with index i in row-major order
+        std::span<Fragment const> operator[](std::size_t const i)const noexcept{
+            return {fragments_.data() + offsets_[i], sizes_[i]};
+        }
+
+        /// \brief Drop all fragments of pixel i behind the first count ones
+        void shrink(std::size_t const i, std::size_t const count)noexcept{
+            sizes_[i] = static_cast<std::uint32_t>(count);
+        }
+
+        /// \brief Bytes allocated for pixel offsets, pixel sizes and fragments
+        std::size_t memory_usage()const noexcept{
+            return offsets_.size() * sizeof(std::size_t) + sizes_.size() * sizeof(std::uint32_t) +
+                fragments_.size() * sizeof(Fragment);
+        }
+
+    private:
+        std::size_t w_;
+        std::size_t h_;
+        std::vector<std::size_t> offsets_;
+        std::vector<std::uint32_t> sizes_;
+        std::vector<Fragment> fragments_;
+    };
+
+
+}
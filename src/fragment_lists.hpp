@@ -0,0 +1,85 @@
+#pragma once
+
+#include "bitmap/bitmap.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Appends fragments to the per pixel lists of a vector image with an optional capacity per pixel
+    ///
+    /// Without capacity every fragment is appended. With capacity K a pixel keeps only the K most relevant
+    /// fragments by the order more_relevant(a, b). Up to K fragments the list stays in serial order. The first
+    /// fragment beyond turns the list into a heap with the least relevant fragment on top, every later fragment
+    /// replaces the top if it is more relevant. So the memory per pixel is bound by K, but the order of the kept
+    /// fragments of a capped pixel is no longer the serial one.
+    template <typename Fragment>
+    class fragment_lists{
+    public:
+        /// \brief True if fragment a is more relevant than fragment b
+        using relevance = bool (*)(Fragment const& a, Fragment const& b);
+
+        /// \brief A capacity of 0 keeps all fragments
+        fragment_lists(
+            bmp::bitmap<std::vector<Fragment>>& image,
+            std::size_t const capacity,
+            relevance const more_relevant
+        )
+            : image_(image)
+            , capacity_(capacity)
+            , more_relevant_(more_relevant)
+            , capped_(capacity > 0 ? image.point_count() : 0) {}
+
+        std::size_t w()const noexcept{
+            return image_.w();
+        }
+
+        std::size_t h()const noexcept{
+            return image_.h();
+        }
+
+        /// \brief Add a fragment to the pixel with index i in row-major order
+        ///
+        /// Concurrent calls are safe for distinct pixels.
+        void push(std::size_t const i, Fragment const& fragment){
+            auto& list = image_.data()[i];
+            if(capacity_ == 0 || list.size() < capacity_){
+                list.push_back(fragment);
+                return;
+            }
+
+            if(!capped_[i]){
+                std::ranges::make_heap(list, more_relevant_);
+                capped_[i] = 1;
+            }
+
+            if(more_relevant_(fragment, list.front())){
+                std::ranges::pop_heap(list, more_relevant_);
+                list.back() = fragment;
+                std::ranges::push_heap(list, more_relevant_);
+            }
+        }
+
+        /// \brief Add a fragment to pixel (x, y)
+        void push(std::size_t const x, std::size_t const y, Fragment const& fragment){
+            push(y * image_.w() + x, fragment);
+        }
+
+        /// \brief Count of pixels that received more fragments than the capacity
+        std::size_t capped_count()const noexcept{
+            return static_cast<std::size_t>(std::ranges::count(capped_, std::uint8_t(1)));
+        }
+
+    private:
+        bmp::bitmap<std::vector<Fragment>>& image_;
+        std::size_t capacity_;
+        relevance more_relevant_;
+        std::vector<std::uint8_t> capped_;
+    };
+
+
+}
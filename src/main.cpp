@@ -1,5 +1,22 @@
 #include "ply.hpp"
 #include "image_format_png.hpp"
+#include "bbf_mapped_image.hpp"
+#include "bbf_tile_writer.hpp"
+#include "bitmap_view.hpp"
+#include "fragment_buffer.hpp"
+#include "fragment_lists.hpp"
+#include "parallel.hpp"
+#include "raster_grid.hpp"
+#include "raster_index.hpp"
+#include "raster_point.hpp"
+#include "raster_rows.hpp"
+#include "raster_values.hpp"
+#include "reference_tiles.hpp"
+#include "span_kernel.hpp"
+#include "sparse_raster_grid.hpp"
+#include "tile_bins.hpp"
+#include "triangle_rasterizer.hpp"
+#include "work_stealing.hpp"
 
 #include "bitmap/bitmap.hpp"
 #include "bitmap/binary_write.hpp"
@@ -9,6 +26,9 @@
 #include <argparse/argparse.hpp>
 
 #include <algorithm>
+#include <bit>
+#include <chrono>
+#include <memory>
 #include <numeric>
 #include <span>
 #include <tuple>
@@ -39,6 +59,15 @@ namespace ply2image{
     constexpr std::string_view raster_filter_strings[] = {"min"sv, "max"sv, "none"sv};
 
 
+    enum class aux_output{
+        none = 0,
+        channels = 1,
+        files = 2
+    };
+
+    constexpr std::string_view aux_output_strings[] = {"none"sv, "channels"sv, "files"sv};
+
+
     std::string valid_values_string(std::ranges::output_range<std::string_view> auto const& list){
         auto const begin = std::ranges::begin(list);
         auto const end = std::ranges::end(list);
@@ -117,65 +146,144 @@ namespace ply2image{
         }
     }
 
-    struct point{
-        double x;
-        double y;
-        double v;
-    };
+    struct max_value_filter{
+        template <typename Fragment>
+        constexpr auto operator()(std::span<Fragment const> const p)const{
+            return std::ranges::max_element(p, [](Fragment const& a, Fragment const& b){
+                return a.value < b.value;
+            });
+        }
 
-    struct raster_point{
-        double x;
-        double y;
-        double v;
-        std::int64_t rx;
-        std::int64_t ry;
+        /// \brief Start value of a running maximum, every value replaces it
+        static constexpr double initial = -std::numeric_limits<double>::infinity();
 
-        operator bmp::point<double>()const{
-            return {x, y};
-        };
+        /// \brief True if a fragment with value candidate replaces the reference in a running maximum
+        static constexpr bool replaces(double const candidate, double const reference)noexcept{
+            return reference < candidate;
+        }
+
+        /// \brief Higher values are more relevant for fragment_lists
+        static bool more_relevant(raw_pixel<raster_point> const& a, raw_pixel<raster_point> const& b)noexcept{
+            return b.value < a.value;
+        }
     };
 
-    template <typename Point>
-    struct raw_pixel;
+    struct min_value_filter{
+        template <typename Fragment>
+        constexpr auto operator()(std::span<Fragment const> const p)const{
+            return std::ranges::min_element(p, [](Fragment const& a, Fragment const& b){
+                return a.value < b.value;
+            });
+        }
+
+        /// \brief Start value of a running minimum, every value replaces it
+        static constexpr double initial = std::numeric_limits<double>::infinity();
+
+        /// \brief True if a fragment with value candidate replaces the reference in a running minimum
+        static constexpr bool replaces(double const candidate, double const reference)noexcept{
+            return candidate < reference;
+        }
 
-    template <>
-    struct raw_pixel<point>{
-        double weight;
-        double value;
+        /// \brief Lower values are more relevant for fragment_lists
+        static bool more_relevant(raw_pixel<raster_point> const& a, raw_pixel<raster_point> const& b)noexcept{
+            return a.value < b.value;
+        }
     };
 
-    template <>
-    struct raw_pixel<raster_point>{
-        double weight;
-        double value;
-        std::int64_t rx;
-        std::int64_t ry;
+    struct none_filter{
+        /// \brief Higher weights are more relevant for fragment_lists
+        static bool more_relevant(raw_pixel<raster_point> const& a, raw_pixel<raster_point> const& b)noexcept{
+            return b.weight < a.weight;
+        }
     };
 
 
-    struct max_value_filter{
-        constexpr auto operator()(std::vector<raw_pixel<raster_point>> const& p)const{
-            return std::ranges::max_element(p, [](raw_pixel<raster_point> const& a, raw_pixel<raster_point> const& b){
-                return a.value < b.value;
-            });
+    /// \brief Call f with the filter object of raster filter
+    template <typename F>
+    decltype(auto) visit_raster_filter(raster_filter const filter, F&& f){
+        switch(filter){
+            case raster_filter::min:
+                return f(min_value_filter{});
+            case raster_filter::max:
+                return f(max_value_filter{});
+            case raster_filter::none:
+                return f(none_filter{});
         }
-    };
+        throw std::logic_error("invalid raster filter");
+    }
 
-    struct min_value_filter{
-        constexpr auto operator()(std::vector<raw_pixel<raster_point>> const& p)const{
-            return std::ranges::min_element(p, [](raw_pixel<raster_point> const& a, raw_pixel<raster_point> const& b){
-                return a.value < b.value;
-            });
+    /// \brief Keep only the fragments that are adjacent in the raster to the reference fragment of the filter
+    ///
+    /// The kept fragments are moved to the front in their original order.
+    ///
+    /// \return count of kept fragments
+    template <typename Fragment, typename RasterFilter>
+    std::size_t apply_raster_filter(std::span<Fragment> const p, RasterFilter const& raster_filter){
+        if(p.empty()){
+            return 0;
         }
+
+        auto const iter = raster_filter(std::span<Fragment const>(p));
+        auto const end = std::remove_if(p.begin(), p.end(),
+            [ref_rx = std::int64_t(iter->rx), ref_ry = std::int64_t(iter->ry)](Fragment const& v){
+                return std::abs(ref_rx - v.rx) > 1 || std::abs(ref_ry - v.ry) > 1;
+            });
+        return static_cast<std::size_t>(end - p.begin());
+    }
+
+
+    enum class render_engine{
+        vector = 0,
+        csr = 1,
+        streaming = 2
     };
 
-    struct none_filter{};
+    constexpr std::string_view render_engine_strings[] = {"vector"sv, "csr"sv, "streaming"sv};
+
+    constexpr std::string_view simd_level_strings[] = {"auto"sv, "scalar"sv, "sse4.2"sv, "avx2"sv, "avx512"sv};
+
+    constexpr std::string_view quad_tessellation_strings[] = {"four"sv, "fixed"sv, "shorter"sv, "depth"sv};
+
+    constexpr std::string_view output_sync_strings[] = {"none"sv, "msync"sv, "fdatasync"sv};
+
+
+    /// \brief Settings of the render engine, all but tessellation, subpixel_bits, compact_fragments and
+    ///        max_fragments_per_pixel do not change the result
+    struct render_options{
+        /// \brief Fragment storage of the raster interpolation
+        render_engine engine = render_engine::vector;
+
+        /// \brief Count of worker threads, 0 uses the hardware concurrency
+        std::size_t threads = 0;
+
+        /// \brief Print diagnostics of the engine like the load of the worker threads
+        bool verbose = false;
+
+        /// \brief The points are sorted by raster y, stream the raster with a window of two raster rows
+        bool sorted_raster = false;
+
+        /// \brief Instruction set of the span kernel
+        simd_level simd = simd_level::automatic;
+
+        /// \brief Triangulation of full raster quads
+        quad_tessellation tessellation = quad_tessellation::four;
+
+        /// \brief Fractional bits of the fixed-point rasterization, 0 rasterizes in floating point
+        std::size_t subpixel_bits = 0;
+
+        /// \brief The csr engine stores its fragments as compact_raster_pixel if they fit
+        bool compact_fragments = false;
+
+        /// \brief Capacity of the fragment lists of the vector engine per pixel, 0 keeps all fragments
+        std::size_t max_fragments_per_pixel = 0;
+    };
 
 
     bmp::bitmap<std::vector<raw_pixel<point>>> to_vector_image(
         std::size_t const width,
         std::size_t const height,
-        std::vector<point> const& points
+        std::vector<point> const& points,
+        render_options const&
     ){
         bmp::bitmap<std::vector<raw_pixel<point>>> vector_image(width, height);
         for(auto const& p: points){
@@ -205,341 +313,1688 @@ namespace ply2image{
         return vector_image;
     }
 
-    struct raster_range{
-        std::int64_t min_x;
-        std::int64_t max_x;
-        std::int64_t min_y;
-        std::int64_t max_y;
-
-        std::size_t w()const{
-            return static_cast<std::size_t>(max_x + 1 - min_x);
+    /// \brief Remove all points that can not contribute to a pixel of the target image
+    ///
+    /// A point contributes to the four pixels around its position, so points up to one pixel left and above of
+    /// the image still matter.
+    ///
+    /// \return count of removed points
+    std::size_t cull_points(std::size_t const width, std::size_t const height, std::vector<point>& points){
+        auto const w = static_cast<double>(width);
+        auto const h = static_cast<double>(height);
+        return std::erase_if(points, [w, h](point const& p){
+                return !(p.x >= -1. && p.x < w && p.y >= -1. && p.y < h);
+            });
+    }
+
+    /// \brief Cohen-Sutherland outcode of a position relativ to the target image
+    ///
+    /// NaN positions get all bits, so they never prevent a neighbour from being kept.
+    constexpr std::uint8_t image_outcode(double const x, double const y, double const w, double const h)noexcept{
+        return static_cast<std::uint8_t>(
+            (!(x >= 0.) ? 0x1 : 0x0) |
+            (!(x <= w - 1.) ? 0x2 : 0x0) |
+            (!(y >= 0.) ? 0x4 : 0x0) |
+            (!(y <= h - 1.) ? 0x8 : 0x0));
+    }
+
+    /// \brief Outcode of a cell without raster point
+    inline constexpr std::uint8_t absent_code = 0x10;
+
+    /// \brief Flag of a cell whose raster point is a vertex of a quad that may cover the target image
+    inline constexpr std::uint8_t keep_code = 0x20;
+
+    /// \brief Flag all corners of a quad of outcodes if it is not trivially rejected
+    ///
+    /// A quad is trivially rejected if it has less than 3 raster points or all of them are on the same outer side
+    /// of the target image.
+    void flag_kept_quad(std::array<std::uint8_t*, 4> const& quad)noexcept{
+        std::size_t present = 0;
+        std::uint8_t outside = 0x0F;
+        for(auto const code: quad){
+            if(!(*code & absent_code)){
+                ++present;
+                outside &= *code;
+            }
+        }
+
+        if(present < 3 || (outside & 0x0F) != 0){
+            return;
+        }
+
+        for(auto const code: quad){
+            *code |= keep_code;
+        }
+    }
+
+    /// \brief Flag all corners of the quads between two rows of outcodes that are not trivially rejected
+    void flag_kept_quads(std::uint8_t* const top, std::uint8_t* const bottom, std::size_t const w)noexcept{
+        for(std::size_t ix = 0; ix + 1 < w; ++ix){
+            flag_kept_quad({{&top[ix], &top[ix + 1], &bottom[ix], &bottom[ix + 1]}});
+        }
+    }
+
+    /// \brief Same as cull_points for a sparsely filled raster range, the outcodes are found by a raster_index
+    ///
+    /// \return count of removed points
+    std::size_t cull_sparse_points(
+        std::size_t const width,
+        std::size_t const height,
+        std::vector<raster_point>& points
+    ){
+        auto const w = static_cast<double>(width);
+        auto const h = static_cast<double>(height);
+
+        raster_index index(points.size());
+        std::vector<std::uint8_t> codes(points.size());
+        for(std::size_t i = 0; i < points.size(); ++i){
+            auto const& p = points[i];
+            if(!index.insert(p.rx, p.ry, i)){
+                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice", p.rx, p.ry));
+            }
+            codes[i] = image_outcode(p.x, p.y, w, h);
+        }
+
+        // every quad with at least 3 points is visited from each of its points
+        for(auto const& p: points){
+            for(auto const qy: {p.ry - 1, p.ry}){
+                for(auto const qx: {p.rx - 1, p.rx}){
+                    std::array<std::uint8_t, 4> absent;
+                    absent.fill(absent_code);
+
+                    std::array<std::uint8_t*, 4> quad;
+                    for(std::size_t c = 0; c < 4; ++c){
+                        auto const i = index.find(
+                            qx + static_cast<std::int64_t>(c & 1),
+                            qy + static_cast<std::int64_t>(c >> 1));
+                        quad[c] = i == raster_index::npos ? &absent[c] : &codes[i];
+                    }
+
+                    flag_kept_quad(quad);
+                }
+            }
+        }
+
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < points.size(); ++i){
+            if(codes[i] & keep_code){
+                points[kept++] = points[i];
+            }
+        }
+
+        auto const culled = points.size() - kept;
+        points.resize(kept);
+        return culled;
+    }
+
+    /// \brief Remove all raster points that can not be a vertex of a triangle covering the target image
+    ///
+    /// Points outside the image are kept as long as one of their raster quads is not trivially rejected, i.e.
+    /// the present quad vertices are not all on the same outer side of the image. This keeps the raster border
+    /// around the image that is needed to triangulate the edge quads. Sparsely filled raster ranges are handled
+    /// by cull_sparse_points.
+    ///
+    /// \return count of removed points
+    std::size_t cull_points(std::size_t const width, std::size_t const height, std::vector<raster_point>& points){
+        auto const w = static_cast<double>(width);
+        auto const h = static_cast<double>(height);
+
+        auto const range = find_raster_range(points);
+        if(range.w() < 2 || range.h() < 2){
+            throw std::runtime_error("raster interpolation requires at least 2 columns and 2 rows");
+        }
+
+        if(prefer_sparse_raster(points.size(), range)){
+            return cull_sparse_points(width, height, points);
+        }
+
+        bmp::bitmap<std::uint8_t> codes(range.w(), range.h(), absent_code);
+        for(auto const& p: points){
+            auto& code = codes(range.x(p.rx), range.y(p.ry));
+            if(code != absent_code){
+                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice", p.rx, p.ry));
+            }
+            code = image_outcode(p.x, p.y, w, h);
+        }
+
+        for(std::size_t iy = 0; iy + 1 < codes.h(); ++iy){
+            flag_kept_quads(&codes(0, iy), &codes(0, iy + 1), codes.w());
+        }
+
+        return std::erase_if(points, [&codes, &range](raster_point const& p){
+                return !(codes(range.x(p.rx), range.y(p.ry)) & keep_code);
+            });
+    }
+
+    /// \brief Same as cull_points for points sorted by raster y, with only two raster rows of outcodes in memory
+    ///
+    /// \return count of removed points
+    std::size_t cull_sorted_points(
+        std::size_t const width,
+        std::size_t const height,
+        std::vector<raster_point>& points
+    ){
+        auto const w = static_cast<double>(width);
+        auto const h = static_cast<double>(height);
+
+        auto const range = find_raster_range(points);
+        if(range.w() < 2 || range.h() < 2){
+            throw std::runtime_error("raster interpolation requires at least 2 columns and 2 rows");
+        }
+
+        if(!std::ranges::is_sorted(points, {}, &raster_point::ry)){
+            throw std::runtime_error("the points are not sorted by raster y");
+        }
+
+        // row 0 is the previous raster row, row 1 the current one
+        auto const rw = range.w();
+        std::vector<std::uint8_t> codes(2 * rw, absent_code);
+        std::vector<std::size_t> indices(2 * rw);
+        std::vector<std::uint8_t> keep(points.size());
+
+        auto const take_row = [&](std::size_t const row){
+                for(std::size_t ix = 0; ix < rw; ++ix){
+                    if(codes[row * rw + ix] & keep_code){
+                        keep[indices[row * rw + ix]] = 1;
+                    }
+                }
+            };
+
+        auto current = range.min_y;
+        for(std::size_t i = 0; i < points.size(); ++i){
+            auto const& p = points[i];
+            for(; current < p.ry; ++current){
+                flag_kept_quads(codes.data(), codes.data() + rw, rw);
+                take_row(0);
+                std::copy(codes.begin() + static_cast<std::ptrdiff_t>(rw), codes.end(), codes.begin());
+                std::copy(indices.begin() + static_cast<std::ptrdiff_t>(rw), indices.end(), indices.begin());
+                std::fill(codes.begin() + static_cast<std::ptrdiff_t>(rw), codes.end(), absent_code);
+            }
+
+            auto& code = codes[rw + range.x(p.rx)];
+            if(code != absent_code){
+                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice", p.rx, p.ry));
+            }
+            code = image_outcode(p.x, p.y, w, h);
+            indices[rw + range.x(p.rx)] = i;
+        }
+
+        flag_kept_quads(codes.data(), codes.data() + rw, rw);
+        take_row(0);
+        take_row(1);
+
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < points.size(); ++i){
+            if(keep[i]){
+                points[kept++] = points[i];
+            }
+        }
+
+        auto const culled = points.size() - kept;
+        points.resize(kept);
+        return culled;
+    }
+
+
+    class percent_printer{
+    public:
+        struct lazy_incer{
+            percent_printer& printer;
+
+            ~lazy_incer(){
+                ++printer;
+            }
+        };
+
+        percent_printer(std::size_t const label_width, std::string_view const base_line_label)
+            : label_width_(label_width)
+        {
+            if(base_line_label.size() > label_width_){
+                throw std::logic_error("label width is larger then specified");
+            }
+
+            fmt::print("{:>{}s}: "
+                "===================================================================================================="
+                "\n", base_line_label, label_width_);
+            std::fflush(stdout);
+        }
+
+        void init(std::string_view const label, std::size_t const count){
+            if(label.size() > label_width_){
+                throw std::logic_error("label width is larger then specified");
+            }
+
+            fmt::print("{:>{}s}: ", label, label_width_);
+            std::fflush(stdout);
+
+            count_ = count;
+            prints_ = 0;
+            i_ = 0;
+        }
+
+        lazy_incer lazy_inc(){
+            return {*this};
+        }
+
+    private:
+        void operator++(){
+            ++i_;
+
+            if(count_ == 0){
+                throw std::logic_error("percent printer used without init call");
+            }
+
+            if(i_ > count_){
+                throw std::logic_error("percent printer run out of range");
+            }
+
+            auto const percent =
+                static_cast<std::size_t>(std::ceil(static_cast<double>(i_) / static_cast<double>(count_) * 100.));
+
+            bool need_flush = false;
+            for(; prints_ < percent; ++prints_){
+                fmt::print(">");
+                need_flush = true;
+            }
+
+            if(i_ == count_){
+                fmt::print(" done\n");
+                need_flush = true;
+            }
+
+            if(need_flush){
+                std::fflush(stdout);
+            }
+        }
+
+        std::size_t label_width_ = 0;
+        std::size_t count_ = 0;
+        std::size_t prints_ = 0;
+        std::size_t i_ = 0;
+    };
+
+    /// \brief Triangles [first, last) of a batch within the pixel rows [y_begin, y_end)
+    struct triangle_slice{
+        std::size_t first;
+        std::size_t last;
+        std::size_t y_begin;
+        std::size_t y_end;
+    };
+
+    /// \brief Slice of all triangles of a batch over all pixel rows
+    inline triangle_slice whole_batch(triangle_batch const& batch)noexcept{
+        return {0, batch.size(), 0, std::numeric_limits<std::size_t>::max()};
+    }
+
+    /// \brief Call f(first, last) for every run of consecutive triangles of a slice that the reference tiles may
+    ///        accept, with no_reference_tiles the whole slice is one run
+    ///
+    /// Culling whole triangles keeps the serial order of the remaining fragments.
+    template <typename Tiles, typename F>
+    void for_each_accepted_run(
+        triangle_batch const& batch,
+        Tiles& tiles,
+        triangle_slice const& slice,
+        F const& f
+    ){
+        if constexpr(std::same_as<Tiles, no_reference_tiles>){
+            f(slice.first, slice.last);
+        }else{
+            std::size_t culled = 0;
+            auto first = slice.first;
+            for(auto i = slice.first; i < slice.last; ++i){
+                if(tiles.may_accept(batch, i)){
+                    continue;
+                }
+
+                if(first < i){
+                    f(first, i);
+                }
+                first = i + 1;
+                ++culled;
+            }
+
+            if(first < slice.last){
+                f(first, slice.last);
+            }
+
+            tiles.count_triangles(slice.last - slice.first, culled);
+        }
+    }
+
+    /// \brief Call f(tiles) with the reference tiles of the raster filters for the points
+    ///
+    /// A triangle is culled only if it can pass none of the filters. The raster filter none and a cap of the
+    /// fragments per pixel get no_reference_tiles, with a cap the culled fragments would leave room for others. The
+    /// count of culled triangles is printed after f.
+    template <typename F>
+    void visit_reference_tiles(
+        std::size_t const width,
+        std::size_t const height,
+        std::vector<raster_point> const& points,
+        render_options const& options,
+        std::span<raster_filter const> const filters,
+        F&& f
+    ){
+        auto const cull = [&f](auto& tiles){
+                f(tiles);
+                fmt::print("{:d} of {:d} triangles culled by the reference tiles\n", tiles.culled(), tiles.total());
+            };
+
+        if(options.max_fragments_per_pixel == 0 && !contains(filters, raster_filter::none)){
+            auto const min = contains(filters, raster_filter::min);
+            auto const max = contains(filters, raster_filter::max);
+            if(min && max){
+                reference_tiles_pair<min_value_filter, max_value_filter> tiles(width, height, points);
+                cull(tiles);
+            }else if(min){
+                reference_tiles<min_value_filter> tiles(width, height, points);
+                cull(tiles);
+            }else{
+                reference_tiles<max_value_filter> tiles(width, height, points);
+                cull(tiles);
+            }
+            return;
+        }
+
+        no_reference_tiles tiles;
+        f(tiles);
+    }
+
+    /// \brief Rasterize all raster rows in order into the fragment lists of the vector image
+    ///
+    /// Triangles that the reference tiles reject are skipped, see for_each_accepted_run.
+    template <typename Rows, typename Tiles>
+    void rasterize_serial(
+        Rows const& rows,
+        fragment_lists<raw_pixel<raster_point>>& fragments,
+        percent_printer& progress,
+        Tiles& tiles
+    ){
+        progress.init("raster interpolation", rows.count());
+        rows.for_each(fragments.w(), fragments.h(), [&](triangle_batch const& batch){
+                auto const printer = progress.lazy_inc();
+
+                for_each_accepted_run(batch, tiles, whole_batch(batch),
+                    [&](std::size_t const first, std::size_t const last){
+                        batch.rasterize([&fragments, &tiles](
+                                std::size_t const x, std::size_t const y, raw_pixel<raster_point> const& fragment
+                            ){
+                                fragments.push(x, y, fragment);
+                                tiles.add(x, y, fragment.value);
+                            }, first, last, 0, fragments.h());
+                    });
+            });
+    }
+
+    /// \brief Position of a part of the rasterization in the serial fragment order of raster row, triangle of the
+    ///        raster row and pixel row
+    struct raster_part{
+        std::size_t iy;
+        std::size_t triangle;
+        std::size_t y;
+
+        auto operator<=>(raster_part const&)const = default;
+    };
+
+    /// \brief Triangles with a bigger clamped bounding box are rasterized in strips of about this many pixels
+    inline constexpr std::size_t huge_triangle_pixels = 4096;
+
+    /// \brief Task of rasterize_tasks
+    ///
+    /// Without batch the task covers the raster rows [begin, end), otherwise the pixel rows [begin, end) of the
+    /// triangle with index triangle in the set up raster row iy.
+    struct raster_task{
+        std::size_t begin;
+        std::size_t end;
+        std::shared_ptr<triangle_batch const> batch;
+        std::size_t iy;
+        std::size_t triangle;
+    };
+
+    /// \brief Rasterize all raster rows of a grid_rows with the work-stealing scheduler
+    ///
+    /// Raster row ranges are split in halves down to a grain of rows. Triangles whose bounding box exceeds
+    /// huge_triangle_pixels are split off their raster row into tasks of pixel row strips. run(worker, part, batch,
+    /// slice) is called concurrently, every part starts at a distinct position of the serial order. row_done() is
+    /// called concurrently after every raster row.
+    ///
+    /// \return the load of every worker
+    template <typename Rows, typename Run, typename RowDone>
+    std::vector<worker_stats> rasterize_tasks(
+        Rows const& raster_rows,
+        std::size_t const width,
+        std::size_t const height,
+        std::size_t const threads,
+        Run const& run,
+        RowDone const& row_done
+    ){
+        struct worker_batches{
+            std::shared_ptr<triangle_batch> row;
+            triangle_batch strip;
+            quad_path_counts quad_paths;
+        };
+
+        std::vector<worker_batches> batches;
+        for(std::size_t i = 0; i < threads; ++i){
+            batches.push_back({nullptr, raster_rows.make_batch(), {}});
+        }
+        auto const rows = raster_rows.count();
+        auto const grain = std::max<std::size_t>(rows / (threads * 16), 1);
+
+        auto stats = work_stealing_run(threads, std::vector<raster_task>{{0, rows, nullptr, 0, 0}},
+            [&](raster_task task, task_spawner<raster_task> const& spawn){
+                auto& own = batches[spawn.worker()];
+                if(task.batch){
+                    auto const box = task.batch->box(task.triangle);
+                    auto const strip_rows = std::max<std::size_t>(huge_triangle_pixels / (box.tx - box.fx + 1), 1);
+                    while(task.end - task.begin > strip_rows){
+                        auto const mid = task.begin + (task.end - task.begin) / 2;
+                        spawn({mid, task.end, task.batch, task.iy, task.triangle});
+                        task.end = mid;
+                    }
+
+                    own.strip.clear();
+                    own.strip.copy_triangle(*task.batch, task.triangle);
+                    run(spawn.worker(), raster_part{task.iy, task.triangle, task.begin}, own.strip,
+                        triangle_slice{0, 1, task.begin, task.end});
+                    return;
+                }
+
+                while(task.end - task.begin > grain){
+                    auto const mid = task.begin + (task.end - task.begin) / 2;
+                    spawn({mid, task.end, nullptr, 0, 0});
+                    task.end = mid;
+                }
+
+                for(auto iy = task.begin; iy < task.end; ++iy){
+                    if(!own.row){
+                        own.row = std::make_shared<triangle_batch>(raster_rows.make_batch());
+                    }
+
+                    auto& batch = *own.row;
+                    own.quad_paths += raster_rows.setup_row(iy, width, height, batch);
+
+                    std::size_t first = 0;
+                    for(std::size_t i = 0; i < batch.size(); ++i){
+                        auto const box = batch.box(i);
+                        if((box.tx - box.fx + 1) * (box.ty - box.fy + 1) <= huge_triangle_pixels){
+                            continue;
+                        }
+
+                        if(first < i){
+                            run(spawn.worker(), raster_part{iy, first, 0}, batch, triangle_slice{first, i, 0, height});
+                        }
+                        spawn({box.fy, box.ty + 1, own.row, iy, i});
+                        first = i + 1;
+                    }
+
+                    if(first < batch.size()){
+                        run(spawn.worker(), raster_part{iy, first, 0}, batch,
+                            triangle_slice{first, batch.size(), 0, height});
+                    }
+
+                    // the strip tasks keep the batch
+                    if(own.row.use_count() > 1){
+                        own.row.reset();
+                    }
+
+                    row_done();
+                }
+            });
+
+        for(auto const& own: batches){
+            raster_rows.add_quad_paths(own.quad_paths);
+        }
+
+        return stats;
+    }
+
+    /// \brief Print the load of the workers of a work_stealing_run
+    void print_worker_stats(std::vector<worker_stats> const& stats){
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        for(std::size_t i = 0; i < stats.size(); ++i){
+            fmt::print("worker {:d}: {:d} tasks, {:d} stolen, busy {:.1f} ms, idle {:.1f} ms\n", i, stats[i].tasks,
+                stats[i].steals, milliseconds(stats[i].busy).count(), milliseconds(stats[i].idle).count());
+        }
+    }
+
+    /// \brief Rasterize raster rows concurrently and merge the parts in serial order
+    ///
+    /// Every part of rasterize_tasks collects its fragments separately, bucketed by blocks of output rows. The
+    /// parts are sorted by their position in the serial order. The merge walks the blocks concurrently and appends
+    /// the buckets of all parts in that order. So every pixel receives its fragments in the same order as with
+    /// rasterize_serial, independent of the scheduling. The buckets hold all fragments until the merge, so a
+    /// capacity of the fragment lists would not bound the memory, capped fragment lists are filled by
+    /// rasterize_serial instead. The workers share the reference tiles, which triangles they reject depends on the
+    /// scheduling, but never the result.
+    template <typename Rows, typename Tiles>
+    void rasterize_parallel(
+        Rows const& rows,
+        fragment_lists<raw_pixel<raster_point>>& fragments,
+        percent_printer& progress,
+        std::size_t const threads,
+        bool const verbose,
+        Tiles& tiles
+    ){
+        using fragment_bucket = std::vector<std::pair<std::size_t, raw_pixel<raster_point>>>;
+
+        struct fragment_part{
+            raster_part part;
+            std::vector<fragment_bucket> buckets;
+        };
+
+        auto const block_count = std::min(fragments.h(), threads * 4);
+        auto const block_rows = (fragments.h() + block_count - 1) / block_count;
+
+        std::vector<std::vector<fragment_part>> worker_parts(threads);
+
+        std::mutex progress_mutex;
+        progress.init("raster interpolation", rows.count());
+        auto const stats = rasterize_tasks(rows, fragments.w(), fragments.h(), threads,
+            [&](std::size_t const worker, raster_part const& part, triangle_batch const& batch,
+                triangle_slice const& slice
+            ){
+                auto& buckets = worker_parts[worker].emplace_back(
+                    fragment_part{part, std::vector<fragment_bucket>(block_count)}).buckets;
+                for_each_accepted_run(batch, tiles, slice, [&](std::size_t const first, std::size_t const last){
+                        batch.rasterize(
+                            [&buckets, &tiles, block_rows, width = fragments.w()](
+                                std::size_t const x, std::size_t const y, raw_pixel<raster_point> const& fragment
+                            ){
+                                buckets[y / block_rows].emplace_back(y * width + x, fragment);
+                                tiles.add_concurrent(x, y, fragment.value);
+                            }, first, last, slice.y_begin, slice.y_end);
+                    });
+            },
+            [&]{
+                std::lock_guard lock(progress_mutex);
+                auto const printer = progress.lazy_inc();
+            });
+
+        std::vector<fragment_part*> parts;
+        for(auto& list: worker_parts){
+            for(auto& part: list){
+                parts.push_back(&part);
+            }
+        }
+        std::ranges::sort(parts, {}, [](fragment_part const* const p){ return p->part; });
+
+        progress.init("merge raster parts", block_count);
+        parallel_for(block_count, threads, [&](std::size_t const block){
+                for(auto const part: parts){
+                    for(auto const& [index, fragment]: part->buckets[block]){
+                        fragments.push(index, fragment);
+                    }
+                    fragment_bucket().swap(part->buckets[block]);
+                }
+
+                std::lock_guard lock(progress_mutex);
+                auto const printer = progress.lazy_inc();
+            });
+
+        if(verbose){
+            print_worker_stats(stats);
+        }
+    }
+
+    /// \brief Make fragment the reference of a pixel if there is none yet or the raster filter replaces it
+    template <typename RasterFilter>
+    void update_reference(reference_pixel& pixel, raw_pixel<raster_point> const& fragment)noexcept{
+        if(!pixel.valid || RasterFilter::replaces(fragment.value, pixel.value)){
+            pixel = {fragment.value, fragment.rx, fragment.ry, true};
+        }
+    }
+
+    /// \brief True if the raster id of fragment is within the ±1 raster neighbourhood of the reference
+    inline bool adjacent_to_reference(
+        reference_pixel const& reference,
+        raw_pixel<raster_point> const& fragment
+    )noexcept{
+        return std::abs(reference.rx - fragment.rx) <= 1 && std::abs(reference.ry - fragment.ry) <= 1;
+    }
+
+    /// \brief Raster filter reference fragments per pixel of the min and the max filter, each is empty if unused
+    struct filter_references{
+        bmp::bitmap<reference_pixel> min;
+        bmp::bitmap<reference_pixel> max;
+
+        /// \brief True if the fragment of pixel (x, y) passes the raster filter
+        template <typename RasterFilter>
+        bool accepts(
+            RasterFilter const&,
+            std::size_t const x,
+            std::size_t const y,
+            raw_pixel<raster_point> const& fragment
+        )const noexcept{
+            if constexpr(std::same_as<RasterFilter, min_value_filter>){
+                return adjacent_to_reference(min(x, y), fragment);
+            }else if constexpr(std::same_as<RasterFilter, max_value_filter>){
+                return adjacent_to_reference(max(x, y), fragment);
+            }else{
+                return true;
+            }
+        }
+
+        /// \brief True if the fragment of pixel (x, y) passes the raster filter
+        bool accepts(
+            raster_filter const filter,
+            std::size_t const x,
+            std::size_t const y,
+            raw_pixel<raster_point> const& fragment
+        )const{
+            return visit_raster_filter(filter, [&](auto const& raster_filter){
+                    return accepts(raster_filter, x, y, fragment);
+                });
+        }
+    };
+
+    /// \brief Find the references of the min and the max filter among filters for every pixel in an extra pass
+    ///        over the raster rows, there is no pass if filters contains neither
+    ///
+    /// The reference is the first fragment in serial order that no later fragment replaces, this is the same
+    /// fragment that apply_raster_filter selects. Triangles that the reference tiles reject are skipped, they can
+    /// not contain the reference. The bounds of the tiles are final afterwards.
+    template <typename Rows, typename Tiles>
+    filter_references find_references(
+        Rows const& rows,
+        std::size_t const width,
+        std::size_t const height,
+        std::span<raster_filter const> const filters,
+        percent_printer& progress,
+        Tiles& tiles
+    ){
+        auto const find_min = contains(filters, raster_filter::min);
+        auto const find_max = contains(filters, raster_filter::max);
+        filter_references references{
+            .min = bmp::bitmap<reference_pixel>(find_min ? width : 0, find_min ? height : 0, reference_pixel{}),
+            .max = bmp::bitmap<reference_pixel>(find_max ? width : 0, find_max ? height : 0, reference_pixel{})};
+        if(!find_min && !find_max){
+            return references;
+        }
+
+        progress.init("reference pass", rows.count());
+        rows.for_each(width, height, [&](triangle_batch const& batch){
+                auto const printer = progress.lazy_inc();
+
+                for_each_accepted_run(batch, tiles, whole_batch(batch),
+                    [&](std::size_t const first, std::size_t const last){
+                        batch.rasterize([&](
+                                std::size_t const x, std::size_t const y, raw_pixel<raster_point> const& fragment
+                            ){
+                                if(find_min){
+                                    update_reference<min_value_filter>(references.min(x, y), fragment);
+                                }
+                                if(find_max){
+                                    update_reference<max_value_filter>(references.max(x, y), fragment);
+                                }
+                                tiles.add(x, y, fragment.value);
+                            }, first, last, 0, height);
+                    });
+            });
+
+        tiles.update_bounds();
+        return references;
+    }
+
+    /// \brief Rasterize into a fragment buffer with a count pass and a fill pass
+    ///
+    /// The count pass only runs the edge tests and can run on several threads for a whole raster grid. The fill
+    /// pass stores the fragments in serial order, so the result is identical to the vector engine. The fill pass
+    /// skips the triangles that the reference tiles reject, their counted places stay unused. The fragments are
+    /// stored as Fragment, see store_fragment.
+    template <typename Fragment, typename Rows, typename Tiles>
+    fragment_buffer<Fragment> rasterize_csr(
+        Rows const& rows,
+        std::size_t const width,
+        std::size_t const height,
+        percent_printer& progress,
+        std::size_t const threads,
+        bool const verbose,
+        Tiles& tiles
+    ){
+        fragment_buffer<Fragment> buffer(width, height);
+
+        if constexpr(is_grid_rows<Rows>){
+            if(threads > 1){
+                std::mutex progress_mutex;
+                progress.init("count fragments", rows.count());
+                auto const stats = rasterize_tasks(rows, width, height, threads,
+                    [&buffer](
+                        std::size_t, raster_part const&, triangle_batch const& batch, triangle_slice const& slice
+                    ){
+                        batch.cover([&buffer](std::size_t const x, std::size_t const y){
+                                buffer.count_concurrent(x, y);
+                            }, slice.first, slice.last, slice.y_begin, slice.y_end);
+                    },
+                    [&]{
+                        std::lock_guard lock(progress_mutex);
+                        auto const printer = progress.lazy_inc();
+                    });
+                if(verbose){
+                    print_worker_stats(stats);
+                }
+            }
+        }
+
+        if(threads <= 1 || !is_grid_rows<Rows>){
+            progress.init("count fragments", rows.count());
+            rows.for_each(width, height, [&](triangle_batch const& batch){
+                    auto const printer = progress.lazy_inc();
+
+                    batch.cover([&buffer](std::size_t const x, std::size_t const y){
+                            buffer.count(x, y);
+                        });
+                });
+        }
+
+        buffer.allocate();
+        fmt::print("{:d} fragments in {:d} MiB\n", buffer.fragment_count(), buffer.memory_usage() >> 20);
+
+        progress.init("fill fragments", rows.count());
+        rows.for_each(width, height, [&](triangle_batch const& batch){
+                auto const printer = progress.lazy_inc();
+
+                for_each_accepted_run(batch, tiles, whole_batch(batch),
+                    [&](std::size_t const first, std::size_t const last){
+                        batch.rasterize([&buffer, &tiles](
+                                std::size_t const x, std::size_t const y, raw_pixel<raster_point> const& fragment
+                            ){
+                                buffer.push(x, y, store_fragment<Fragment>(fragment));
+                                tiles.add(x, y, fragment.value);
+                            }, first, last, 0, height);
+                    });
+            });
+
+        return buffer;
+    }
+
+    /// \brief Call f with the raster rows of the points
+    ///
+    /// With render_options::sorted_raster the rows are streamed with a sliding window of two raster rows, otherwise
+    /// the whole raster is built first. A sparsely filled raster range is stored in a sparse_raster_grid.
+    ///
+    /// \return false if there are no points and f was not called
+    template <typename F>
+    bool visit_raster_rows(
+        std::vector<raster_point> const& points,
+        render_options const& options,
+        percent_printer& progress,
+        F&& f
+    ){
+        if(points.empty()){
+            fmt::print("no raster points left within the target image\n");
+            return false;
+        }
+
+        auto const range = find_raster_range(points);
+        if(range.w() < 2 || range.h() < 2){
+            throw std::runtime_error("raster interpolation requires at least 2 columns and 2 rows");
+        }
+
+        fmt::print("raster with origin {:d}x{:d} and size {:d}x{:d}\n",
+            range.min_x, range.min_y, range.w(), range.h());
+
+        auto const settings = make_raster_settings(options.simd, options.subpixel_bits);
+        fmt::print("{:s} span kernel\n", simd_level_strings[static_cast<std::size_t>(settings.kernel.level)]);
+        if(options.subpixel_bits > 0){
+            fmt::print("fixed-point rasterization with {:d} subpixel bits\n", options.subpixel_bits);
+        }
+        auto const visit = [&f](auto const& rows){
+                f(rows);
+
+                auto const& counts = rows.quad_paths();
+                fmt::print("quads over all raster passes: {:d} without pixel centre, {:d} single pixel, {:d} full\n",
+                    counts.empty, counts.single, counts.full);
+            };
+
+        if(options.sorted_raster){
+            visit(sliding_rows(points, range, options.tessellation, settings));
+            return true;
+        }
+
+        if(prefer_sparse_raster(points.size(), range)){
+            sparse_raster_grid raster_image(range);
+            progress.init("create sparse raster image", points.size());
+            for(auto const& p: points){
+                auto const printer = progress.lazy_inc();
+                raster_image.insert(p);
+            }
+
+            fmt::print("sparse raster with {:d} tiles of {:d}x{:d} cells\n", raster_image.tile_count(),
+                sparse_raster_grid::word_bits, sparse_raster_grid::tile_rows);
+            visit(grid_rows(raster_image, options.tessellation, settings));
+            return true;
+        }
+
+        raster_grid raster_image(range);
+        progress.init("create raster image", points.size());
+        for(auto const& p: points){
+            auto const printer = progress.lazy_inc();
+            raster_image.insert(p);
+        }
+
+        visit(grid_rows(raster_image, options.tessellation, settings));
+        return true;
+    }
+
+    /// \brief Rasterize the raster points into fragment lists
+    ///
+    /// A single raster filter is applied to the stored fragments, with several filters they are stored unfiltered
+    /// and every filter is applied when resolving, see resolve_filtered_images. A cap of the fragments per pixel
+    /// keeps the most relevant fragments for the first filter.
+    bmp::bitmap<std::vector<raw_pixel<raster_point>>> to_vector_image(
+        std::size_t const width,
+        std::size_t const height,
+        std::vector<raster_point> const& points,
+        render_options const& options,
+        std::span<raster_filter const> const filters
+    ){
+        bmp::bitmap<std::vector<raw_pixel<raster_point>>> vector_image(width, height);
+        fragment_lists<raw_pixel<raster_point>> fragments(vector_image, options.max_fragments_per_pixel,
+            visit_raster_filter(filters.front(), []<typename RasterFilter>(RasterFilter const&){
+                    return &RasterFilter::more_relevant;
+                }));
+
+        percent_printer progress(30, "base line");
+        visit_reference_tiles(width, height, points, options, filters, [&](auto& tiles){
+                visit_raster_rows(points, options, progress, [&]<typename Rows>(Rows const& rows){
+                        if constexpr(is_grid_rows<Rows>){
+                            if(auto const threads = thread_count(options.threads);
+                                threads > 1 && rows.count() > 1 && options.max_fragments_per_pixel == 0
+                            ){
+                                rasterize_parallel(rows, fragments, progress, threads, options.verbose, tiles);
+                                return;
+                            }
+                        }
+
+                        // a capacity bounds the memory only if every fragment goes to the capped lists at once
+                        rasterize_serial(rows, fragments, progress, tiles);
+                    });
+            });
+
+        if(options.max_fragments_per_pixel > 0){
+            fmt::print("{:d} pixels received more than {:d} fragments and kept the most relevant ones\n",
+                fragments.capped_count(), options.max_fragments_per_pixel);
+        }
+
+        if(filters.size() == 1){
+            visit_raster_filter(filters.front(), [&]<typename RasterFilter>(RasterFilter const& raster_filter){
+                    if constexpr(!std::same_as<RasterFilter, none_filter>){
+                        // filter values via raster information
+                        progress.init("reference filter", vector_image.point_count());
+                        for(auto& p: vector_image){
+                            auto const printer = progress.lazy_inc();
+                            auto const count = apply_raster_filter(std::span(p), raster_filter);
+                            p.erase(p.begin() + static_cast<std::ptrdiff_t>(count), p.end());
+                        }
+                    }
+                });
+        }
+
+        return vector_image;
+    }
+
+    /// \brief True if all fragments of the points fit into compact_raster_pixel
+    ///
+    /// Every fragment carries the raster id of a vertex and a value between the vertex values, so checking the
+    /// points suffices. Half the float range leaves a margin for the rounding of the interpolation.
+    inline bool fits_compact_fragments(std::vector<raster_point> const& points){
+        using id_limits = std::numeric_limits<std::int32_t>;
+        return std::ranges::all_of(points, [](raster_point const& point){
+                return
+                    point.rx >= id_limits::min() && point.rx <= id_limits::max() &&
+                    point.ry >= id_limits::min() && point.ry <= id_limits::max() &&
+                    !(std::abs(point.v) > double(std::numeric_limits<float>::max()) / 2);
+            });
+    }
+
+    /// \brief Rasterize the raster points into a fragment buffer, the raster filters are applied like in
+    ///        to_vector_image
+    template <typename Fragment>
+    fragment_buffer<Fragment> to_fragment_buffer(
+        std::size_t const width,
+        std::size_t const height,
+        std::vector<raster_point> const& points,
+        render_options const& options,
+        std::span<raster_filter const> const filters
+    ){
+        fragment_buffer<Fragment> buffer(width, height);
+
+        percent_printer progress(30, "base line");
+        auto found = false;
+        visit_reference_tiles(width, height, points, options, filters, [&](auto& tiles){
+                found = visit_raster_rows(points, options, progress, [&](auto const& rows){
+                        buffer = rasterize_csr<Fragment>(rows, width, height, progress,
+                            thread_count(options.threads), options.verbose, tiles);
+                    });
+            });
+
+        if(!found){
+            buffer.allocate();
+            return buffer;
+        }
+
+        if(filters.size() == 1){
+            visit_raster_filter(filters.front(), [&]<typename RasterFilter>(RasterFilter const& raster_filter){
+                    if constexpr(!std::same_as<RasterFilter, none_filter>){
+                        // filter values via raster information
+                        progress.init("reference filter", buffer.point_count());
+                        for(std::size_t i = 0; i < buffer.point_count(); ++i){
+                            auto const printer = progress.lazy_inc();
+                            buffer.shrink(i, apply_raster_filter(buffer[i], raster_filter));
+                        }
+                    }
+                });
+        }
+
+        return buffer;
+    }
+
+    /// \brief Throw std::logic_error if a fragment has a negative weight, the rasterizer never produces one
+    template <typename Fragment>
+    void validate_weights(std::span<Fragment const> const data){
+        if(std::ranges::any_of(data, [](Fragment const& v){ return v.weight < 0.; })){
+            throw std::logic_error("negative weight");
+        }
+    }
+
+    /// \brief Per pixel state of the streaming engine
+    struct streaming_pixel{
+        /// \brief Accumulated accepted fragments
+        std::uint32_t count;
+        double first_value;
+        double sum_weight;
+        double sum_value;
+
+        void accumulate(raw_pixel<raster_point> const& fragment){
+#ifndef NDEBUG
+            validate_weights(std::span(&fragment, 1));
+#endif
+
+            if(count++ == 0){
+                first_value = fragment.value;
+            }
+
+            sum_weight += fragment.weight;
+            sum_value += fragment.value * fragment.weight;
+        }
+
+        /// \brief Same rules as resolve_pixel
+        double resolve()const noexcept{
+            if(count == 0){
+                return NaN;
+            }else if(count == 1){
+                return first_value;
+            }else if(sum_weight == 0.){
+                return NaN;
+            }else{
+                return sum_value / sum_weight;
+            }
+        }
+    };
+
+    /// \brief Weighted sums of additional value properties per pixel of the streaming engine
+    ///
+    /// The fragments are accepted and weighted by the streaming_pixel of the primary value, every channel is only
+    /// interpolated with the barycentric weights of the fragment. The vertex values are looked up once per
+    /// triangle.
+    class streaming_channels{
+    public:
+        streaming_channels(std::size_t const width, std::size_t const height, raster_values const& values)
+            : values_(values)
+            , width_(width)
+            , first_(width * height * values.channel_count())
+            , sum_(width * height * values.channel_count()) {}
+
+        /// \brief Must be called before the triangles of the next batch are accumulated
+        void next_batch()noexcept{
+            triangle_ = no_triangle;
+        }
+
+        /// \brief Accumulate the fragment of triangle i at (x, y) with the weight that the primary value got
+        void accumulate(
+            triangle_batch const& batch,
+            std::size_t const i,
+            std::size_t const x,
+            std::size_t const y,
+            double const weight,
+            bool const first
+        ){
+            if(i != triangle_){
+                auto const rx = batch.raster_x(i);
+                auto const ry = batch.raster_y(i);
+                for(std::size_t k = 0; k < 3; ++k){
+                    vertex_[k] = values_(rx[k], ry[k]);
+                }
+                triangle_ = i;
+            }
+
+            auto const w = batch.barycentric(i, x, y);
+            auto const base = (y * width_ + x) * values_.channel_count();
+            for(std::size_t c = 0; c < values_.channel_count(); ++c){
+                // same order as interpolate_pixel
+                auto const value = vertex_[0][c] * w[0] + vertex_[1][c] * w[1] + vertex_[2][c] * w[2];
+                if(first){
+                    first_[base + c] = value;
+                }
+                sum_[base + c] += value * weight;
+            }
+        }
+
+        /// \brief Image of channel c with the same rules as streaming_pixel::resolve
+        bmp::bitmap<double> resolve(std::size_t const c, bmp::bitmap<streaming_pixel> const& state)const{
+            bmp::bitmap<double> image(state.w(), state.h(), NaN);
+            for(std::size_t i = 0; i < state.point_count(); ++i){
+                auto const& pixel = state.data()[i];
+                auto const j = i * values_.channel_count() + c;
+                if(pixel.count == 1){
+                    image.data()[i] = first_[j];
+                }else if(pixel.count > 1 && pixel.sum_weight != 0.){
+                    image.data()[i] = sum_[j] / pixel.sum_weight;
+                }
+            }
+            return image;
+        }
+
+    private:
+        static constexpr std::size_t no_triangle = std::numeric_limits<std::size_t>::max();
+
+        raster_values const& values_;
+        std::size_t width_;
+        std::vector<double> first_;
+        std::vector<double> sum_;
+        std::size_t triangle_ = no_triangle;
+        std::array<std::span<double const>, 3> vertex_;
+    };
+
+    /// \brief Render the raster interpolation without storing fragment lists, images[f] with raster filter
+    ///        filters[f]
+    ///
+    /// With a min or max raster filter the raster is rasterized twice. The first pass finds the references per
+    /// pixel, the second pass only accumulates fragments within the ±1 raster neighbourhood of the reference of
+    /// each filter and skips the triangles that the reference tiles cull. Without these filters a single pass is
+    /// enough. The result only differs from the other engines by the rounding of the summation order.
+    ///
+    /// With values the additional value properties are rendered in the same passes, this requires a single raster
+    /// filter. The reference is selected by the primary value only. Their images are appended to value_images.
+    /// Every pixel of the images is written.
+    ///
+    /// \throw std::logic_error if values are given with several raster filters
+    void render_streaming(
+        std::span<bitmap_view const> const images,
+        std::vector<raster_point> const& points,
+        render_options const& options,
+        std::span<raster_filter const> const filters,
+        raster_values const* const values = nullptr,
+        std::vector<bmp::bitmap<double>>* const value_images = nullptr
+    ){
+        auto const width = images.front().w();
+        auto const height = images.front().h();
+        std::vector<bmp::bitmap<streaming_pixel>> states;
+        for(std::size_t f = 0; f < filters.size(); ++f){
+            states.emplace_back(width, height, streaming_pixel{});
+        }
+
+        std::optional<streaming_channels> channels;
+        if(values != nullptr){
+            if(filters.size() != 1){
+                throw std::logic_error("value properties require a single raster filter");
+            }
+            channels.emplace(width, height, *values);
+        }
+
+        percent_printer progress(30, "base line");
+        auto const accumulation_pass = [&](
+                auto const& rows,
+                auto& tiles,
+                filter_references const& references,
+                auto const& pass_filters
+            ){
+                progress.init("accumulation pass", rows.count());
+                rows.for_each(width, height, [&](triangle_batch const& batch){
+                        auto const printer = progress.lazy_inc();
+                        if(channels){
+                            channels->next_batch();
+                        }
+
+                        for_each_accepted_run(batch, tiles, whole_batch(batch),
+                            [&](std::size_t const first, std::size_t const last){
+                                batch.rasterize_indexed([&](
+                                        std::size_t const i, std::size_t const x, std::size_t const y,
+                                        raw_pixel<raster_point> const& fragment
+                                    ){
+                                        for(std::size_t f = 0; f < pass_filters.size(); ++f){
+                                            if(!references.accepts(pass_filters[f], x, y, fragment)){
+                                                continue;
+                                            }
+
+                                            auto& pixel = states[f](x, y);
+                                            pixel.accumulate(fragment);
+                                            if(channels){
+                                                channels->accumulate(batch, i, x, y, fragment.weight,
+                                                    pixel.count == 1);
+                                            }
+                                        }
+                                    }, first, last, 0, height);
+                            });
+                    });
+            };
+
+        visit_reference_tiles(width, height, points, options, filters, [&](auto& tiles){
+                visit_raster_rows(points, options, progress, [&](auto const& rows){
+                        auto const references = find_references(rows, width, height, filters, progress, tiles);
+
+                        // a single raster filter is known at compile time in the loop over the fragments
+                        if(filters.size() == 1){
+                            visit_raster_filter(filters.front(), [&](auto const& raster_filter){
+                                    accumulation_pass(rows, tiles, references, std::array{raster_filter});
+                                });
+                        }else{
+                            accumulation_pass(rows, tiles, references, filters);
+                        }
+                    });
+            });
+
+        for(std::size_t f = 0; f < filters.size(); ++f){
+            std::ranges::transform(states[f], images[f].begin(), [](streaming_pixel const& pixel){
+                    return pixel.resolve();
+                });
+        }
+
+        if(channels){
+            for(std::size_t c = 0; c < values->channel_count(); ++c){
+                value_images->push_back(channels->resolve(c, states.front()));
+            }
+        }
+    }
+
+    /// \brief Weighted mean of the fragments of a pixel, NaN for pixels without fragments or weights
+    ///
+    /// Weight and value sum are accumulated in one pass. Groups of four fragments are summed pairwise before they
+    /// are added, like std::transform_reduce does. Debug builds validate the weights first.
+    template <typename Fragment>
+    double resolve_pixel(std::span<Fragment const> const data){
+        if(data.size() <= 1){
+            return data.empty() ? NaN : static_cast<double>(data[0].value);
+        }
+
+#ifndef NDEBUG
+        validate_weights(data);
+#endif
+
+        auto const weight = [&data](std::size_t const i){
+                return static_cast<double>(data[i].weight);
+            };
+        auto const value = [&data](std::size_t const i){
+                return static_cast<double>(data[i].value) * data[i].weight;
+            };
+
+        auto sum_weight = 0.;
+        auto sum_value = 0.;
+        std::size_t i = 0;
+        for(; data.size() - i >= 4; i += 4){
+            sum_weight += (weight(i) + weight(i + 1)) + (weight(i + 2) + weight(i + 3));
+            sum_value += (value(i) + value(i + 1)) + (value(i + 2) + value(i + 3));
+        }
+        for(; i < data.size(); ++i){
+            sum_weight += weight(i);
+            sum_value += value(i);
+        }
+
+        if(sum_weight == 0.){
+            return NaN;
+        }
+
+        return sum_value / sum_weight;
+    }
+
+    /// \brief Count of image rows per task of resolve_image
+    inline constexpr std::size_t resolve_block_rows = 16;
+
+    /// \brief Call f(first, last) for the row-major pixel index ranges of the blocks of resolve_block_rows rows
+    ///        of an image, concurrently
+    template <typename F>
+    void for_each_pixel_block(std::size_t const width, std::size_t const height, std::size_t const threads, F const& f){
+        auto const block_size = resolve_block_rows * width;
+        auto const blocks = (height + resolve_block_rows - 1) / resolve_block_rows;
+        parallel_for(blocks, threads, [&](std::size_t const block){
+                f(block * block_size, std::min((block + 1) * block_size, width * height));
+            });
+    }
+
+    /// \brief Call f(i) for the row-major index i of every pixel of an image, concurrently over blocks of rows
+    template <typename F>
+    void for_each_pixel(std::size_t const width, std::size_t const height, std::size_t const threads, F const& f){
+        for_each_pixel_block(width, height, threads, [&f](std::size_t const first, std::size_t const last){
+                for(auto i = first; i < last; ++i){
+                    f(i);
+                }
+            });
+    }
+
+    /// \brief Set every pixel i of the image to resolve(i), concurrently over blocks of rows
+    template <typename Resolve>
+    void resolve_image(bitmap_view const image, std::size_t const threads, Resolve const& resolve){
+        for_each_pixel(image.w(), image.h(), threads, [&](std::size_t const i){
+                image.data()[i] = resolve(i);
+            });
+    }
+
+    /// \brief Set every pixel i of the image to the resolved fragments(i) after the raster filter
+    ///
+    /// The filter is applied to a copy of the fragments, so the same fragments can be resolved with further
+    /// filters afterwards. The result is the same as with filtered fragments.
+    template <typename RasterFilter, typename Fragments>
+    void resolve_filtered_image(
+        bitmap_view const image,
+        std::size_t const threads,
+        RasterFilter const& raster_filter,
+        Fragments const& fragments
+    ){
+        if constexpr(std::same_as<RasterFilter, none_filter>){
+            resolve_image(image, threads, [&fragments](std::size_t const i){
+                    return resolve_pixel(fragments(i));
+                });
+        }else{
+            using fragment_type = typename std::remove_cvref_t<decltype(fragments(0))>::value_type;
+            for_each_pixel_block(image.w(), image.h(), threads, [&](std::size_t const first, std::size_t const last){
+                    std::vector<fragment_type> copy;
+                    for(auto i = first; i < last; ++i){
+                        auto const data = fragments(i);
+                        copy.assign(data.begin(), data.end());
+                        auto const count = apply_raster_filter(std::span(copy), raster_filter);
+                        image.data()[i] = resolve_pixel(std::span<fragment_type const>(copy.data(), count));
+                    }
+                });
         }
+    }
 
-        std::size_t h()const{
-            return static_cast<std::size_t>(max_y + 1 - min_y);
+    /// \brief Set every pixel i of images[f] to the resolved fragments(i) after raster filter filters[f]
+    ///
+    /// A single raster filter has been applied to the stored fragments already, see to_vector_image.
+    template <typename Fragments>
+    void resolve_filtered_images(
+        std::span<bitmap_view const> const images,
+        std::size_t const threads,
+        std::span<raster_filter const> const filters,
+        Fragments const& fragments
+    ){
+        if(filters.size() == 1){
+            resolve_filtered_image(images.front(), threads, none_filter{}, fragments);
+            return;
         }
 
-        std::size_t x(std::int64_t const x)const{
-            return static_cast<std::size_t>(x - min_x);
+        for(std::size_t f = 0; f < filters.size(); ++f){
+            visit_raster_filter(filters[f], [&](auto const& raster_filter){
+                    resolve_filtered_image(images[f], threads, raster_filter, fragments);
+                });
         }
+    }
 
-        std::size_t y(std::int64_t const y)const{
-            return static_cast<std::size_t>(y - min_y);
-        }
+    /// \brief Confidence planes of the raster interpolation, resolved from the same fragments as the image
+    struct aux_planes{
+        /// \brief Names of the planes in channel order, they are also the suffixes of the separate files
+        ///
+        /// - count: count of fragments after the raster filter
+        /// - weight: sum of their weights
+        /// - rx, ry: raster id of the dominant vertex of the fragment with the highest weight
+        /// - dominant_distance: distance in pixels of the pixel centre to the nearest of the dominant vertices of
+        ///   the fragments, the other vertices of their triangles are not known from the fragments
+        ///
+        /// Pixels without fragments have count and weight 0, all other planes are NaN there.
+        static constexpr std::array<std::string_view, 5> names{{
+            "count"sv, "weight"sv, "rx"sv, "ry"sv, "dominant_distance"sv}};
+
+        aux_planes(std::size_t const width, std::size_t const height)
+            : planes{{
+                bmp::bitmap<double>(width, height, 0.),
+                bmp::bitmap<double>(width, height, 0.),
+                bmp::bitmap<double>(width, height, NaN),
+                bmp::bitmap<double>(width, height, NaN),
+                bmp::bitmap<double>(width, height, NaN)}} {}
+
+        std::array<bmp::bitmap<double>, 5> planes;
     };
 
-    raster_range find_raster_range(std::vector<raster_point> const& points){
-        using limits = std::numeric_limits<std::int64_t>;
-        raster_range range{limits::max(), limits::min(), limits::max(), limits::min()};
-        for(auto const& p: points){
-            range.min_x = std::min(range.min_x, p.rx);
-            range.max_x = std::max(range.max_x, p.rx);
-            range.min_y = std::min(range.min_y, p.ry);
-            range.max_y = std::max(range.max_y, p.ry);
+    /// \brief Resolve the auxiliary planes from the fragments(i) of every pixel i
+    ///
+    /// The positions of the dominant vertices are looked up by their raster ids among the rendered points.
+    template <typename Fragments>
+    void resolve_aux_planes(
+        aux_planes& aux,
+        std::vector<raster_point> const& points,
+        std::size_t const threads,
+        Fragments const& fragments
+    ){
+        raster_index index(points.size());
+        for(std::size_t i = 0; i < points.size(); ++i){
+            index.insert(points[i].rx, points[i].ry, i);
         }
-        return range;
-    }
 
+        auto& [count, weight, rx, ry, dominant_distance] = aux.planes;
+        for_each_pixel(count.w(), count.h(), threads, [&](std::size_t const i){
+                auto const data = fragments(i);
+                if(data.empty()){
+                    return;
+                }
 
-    constexpr double sqr(double const v)noexcept{
-        return v * v;
-    }
+                auto const x = static_cast<double>(i % count.w());
+                auto const y = static_cast<double>(i / count.w());
+                auto sum_weight = 0.;
+                auto nearest = std::numeric_limits<double>::infinity();
+                std::size_t dominant = 0;
+                for(std::size_t k = 0; k < data.size(); ++k){
+                    sum_weight += data[k].weight;
+                    if(data[k].weight > data[dominant].weight){
+                        dominant = k;
+                    }
 
-    constexpr double distance(bmp::point<double> const& a, bmp::point<double> const& b){
-        return std::sqrt(sqr(a.x() - b.x()) + sqr(a.y() - b.y()));
-    }
+                    if(auto const j = index.find(data[k].rx, data[k].ry); j != raster_index::npos){
+                        nearest = std::min(nearest, std::hypot(points[j].x - x, points[j].y - y));
+                    }
+                }
 
-    constexpr double area(std::array<bmp::point<double>, 3> const& t){
-        auto const a = distance(t[0], t[1]);
-        auto const b = distance(t[1], t[2]);
-        auto const c = distance(t[2], t[0]);
-        auto const s = (a + b + c) / 2.;
-        return std::sqrt(s * (s - a) * (s - b) * (s - c));
+                count.data()[i] = static_cast<double>(data.size());
+                weight.data()[i] = sum_weight;
+                rx.data()[i] = static_cast<double>(data[dominant].rx);
+                ry.data()[i] = static_cast<double>(data[dominant].ry);
+                if(nearest != std::numeric_limits<double>::infinity()){
+                    dominant_distance.data()[i] = nearest;
+                }
+            });
     }
 
-    constexpr bool is_inside(std::array<raster_point, 3> const& t, bmp::point<double> const& p){
-        constexpr auto sign =
-            [](std::array<bmp::point<double>, 3> const& t){
-                return (t[0].x() - t[2].x()) * (t[1].y() - t[2].y()) - (t[1].x() - t[2].x()) * (t[0].y() - t[2].y());
-            };
-
-        auto const d1 = sign({p, {t[0].x, t[0].y}, {t[1].x, t[1].y}});
-        auto const d2 = sign({p, {t[1].x, t[1].y}, {t[2].x, t[2].y}});
-        auto const d3 = sign({p, {t[2].x, t[2].y}, {t[0].x, t[0].y}});
-
-        auto const neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
-        auto const pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
-
-        return !(neg && pos);
-    }
+    /// \brief Render the points into images, images[f] with raster filter filters[f], with aux the auxiliary
+    ///        planes of the raster interpolation are resolved as well
+    ///
+    /// Every pixel of the images is written, so they need no initialization. Points without raster ids are
+    /// rendered into images.front() without raster filter. The auxiliary planes require raster points, the vector
+    /// or csr engine and a single raster filter.
+    template <typename Point>
+    void render_images(
+        std::span<bitmap_view const> const images,
+        std::vector<Point> const& points,
+        render_options const& options,
+        aux_planes* const aux,
+        std::span<raster_filter const> const filters
+    ){
+        using raw_pixel = ply2image::raw_pixel<Point>;
 
-    class percent_printer{
-    public:
-        struct lazy_incer{
-            percent_printer& printer;
+        auto const width = images.front().w();
+        auto const height = images.front().h();
+        auto const threads = thread_count(options.threads);
 
-            ~lazy_incer(){
-                ++printer;
+        if constexpr(std::same_as<Point, raster_point>){
+            if(options.engine == render_engine::streaming){
+                render_streaming(images, points, options, filters);
+                return;
             }
-        };
 
-        percent_printer(std::size_t const label_width, std::string_view const base_line_label)
-            : label_width_(label_width)
-        {
-            if(base_line_label.size() > label_width_){
-                throw std::logic_error("label width is larger then specified");
-            }
+            auto const resolve = [&](auto const& fragments){
+                    resolve_filtered_images(images, threads, filters, fragments);
+                    if(aux != nullptr){
+                        resolve_aux_planes(*aux, points, threads, fragments);
+                    }
+                };
 
-            fmt::print("{:>{}s}: "
-                "===================================================================================================="
-                "\n", base_line_label, label_width_);
-            std::fflush(stdout);
-        }
+            if(options.engine == render_engine::csr){
+                auto const resolve_buffer = [&resolve](auto const& buffer){
+                        resolve([&buffer](std::size_t const i){
+                                return buffer[i];
+                            });
+                    };
 
-        void init(std::string_view const label, std::size_t const count){
-            if(label.size() > label_width_){
-                throw std::logic_error("label width is larger then specified");
+                if(options.compact_fragments && fits_compact_fragments(points)){
+                    resolve_buffer(to_fragment_buffer<compact_raster_pixel>(width, height, points, options, filters));
+                }else{
+                    if(options.compact_fragments){
+                        fmt::print("raster ids or values exceed the compact fragment format, store wide fragments\n");
+                    }
+                    resolve_buffer(to_fragment_buffer<raw_pixel>(width, height, points, options, filters));
+                }
+                return;
             }
 
-            fmt::print("{:>{}s}: ", label, label_width_);
-            std::fflush(stdout);
-
-            count_ = count;
-            prints_ = 0;
-            i_ = 0;
+            auto const vector_image = to_vector_image(width, height, points, options, filters);
+            resolve([&vector_image](std::size_t const i){
+                    return std::span<raw_pixel const>(vector_image.data()[i]);
+                });
+        }else{
+            auto const vector_image = to_vector_image(width, height, points, options);
+            resolve_image(images.front(), threads, [&vector_image](std::size_t const i){
+                    return resolve_pixel(std::span<raw_pixel const>(vector_image.data()[i]));
+                });
         }
+    }
 
-        lazy_incer lazy_inc(){
-            return {*this};
+    /// \brief Render the points into new images, one per raster filter, see render_images
+    template <typename Point>
+    std::vector<bmp::bitmap<double>> to_images(
+        std::size_t const width,
+        std::size_t const height,
+        std::vector<Point> const& points,
+        render_options const& options,
+        aux_planes* const aux,
+        std::span<raster_filter const> const filters
+    ){
+        std::vector<bmp::bitmap<double>> images;
+        for(std::size_t f = 0; f < filters.size(); ++f){
+            images.emplace_back(width, height);
         }
 
-    private:
-        void operator++(){
-            ++i_;
+        std::vector<bitmap_view> const views(images.begin(), images.end());
+        render_images(std::span<bitmap_view const>(views), points, options, aux, filters);
+        return images;
+    }
 
-            if(count_ == 0){
-                throw std::logic_error("percent printer used without init call");
-            }
+    /// \brief The bins of the tiled render are written to disk above this count of point indices (256 MiB)
+    inline constexpr std::size_t tile_bin_index_limit = std::size_t(1) << 25;
 
-            if(i_ > count_){
-                throw std::logic_error("percent printer run out of range");
-            }
+    /// \brief Square output tiles of the tiled render, the last column and row may be smaller
+    struct output_tiles{
+        output_tiles(std::size_t const width, std::size_t const height, std::size_t const tile_size)
+            : width(width)
+            , height(height)
+            , size(tile_size)
+            , columns((width + tile_size - 1) / tile_size)
+            , rows((height + tile_size - 1) / tile_size) {}
 
-            auto const percent =
-                static_cast<std::size_t>(std::ceil(static_cast<double>(i_) / static_cast<double>(count_) * 100.));
+        std::size_t count()const noexcept{
+            return columns * rows;
+        }
 
-            bool need_flush = false;
-            for(; prints_ < percent; ++prints_){
-                fmt::print(">");
-                need_flush = true;
-            }
+        /// \brief Call f(tile) for every tile that contains a pixel of [left, right] x [top, bottom], the range is
+        ///        clamped to the image
+        template <typename F>
+        void for_each_overlapped(
+            std::int64_t const left,
+            std::int64_t const right,
+            std::int64_t const top,
+            std::int64_t const bottom,
+            F&& f
+        )const{
+            auto const clamp = [](std::int64_t const v, std::size_t const limit){
+                    return static_cast<std::size_t>(std::clamp(v, std::int64_t(0), static_cast<std::int64_t>(limit)));
+                };
 
-            if(i_ == count_){
-                fmt::print(" done\n");
-                need_flush = true;
+            if(right < 0 || bottom < 0 ||
+                left >= static_cast<std::int64_t>(width) || top >= static_cast<std::int64_t>(height) ||
+                left > right || top > bottom
+            ){
+                return;
             }
 
-            if(need_flush){
-                std::fflush(stdout);
+            for(auto ty = clamp(top, height - 1) / size; ty <= clamp(bottom, height - 1) / size; ++ty){
+                for(auto tx = clamp(left, width - 1) / size; tx <= clamp(right, width - 1) / size; ++tx){
+                    f(ty * columns + tx);
+                }
             }
         }
 
-        std::size_t label_width_ = 0;
-        std::size_t count_ = 0;
-        std::size_t prints_ = 0;
-        std::size_t i_ = 0;
+        std::size_t width;
+        std::size_t height;
+        std::size_t size;
+        std::size_t columns;
+        std::size_t rows;
     };
 
-    template <typename RasterFilter>
-    bmp::bitmap<std::vector<raw_pixel<raster_point>>> to_vector_image(
-        std::size_t const width,
-        std::size_t const height,
-        std::vector<raster_point> const& points,
-        RasterFilter const& raster_filter
-    ){
-        auto const range = find_raster_range(points);
-        if(range.w() < 2 || range.h() < 2){
-            throw std::runtime_error("raster interpolation requires at least 2 columns and 2 rows");
+    /// \brief Add the index of every point to the bins of the tiles of the 4 pixels it contributes to
+    void bin_points(std::vector<point> const& points, output_tiles const& tiles, tile_bins& bins){
+        for(std::size_t i = 0; i < points.size(); ++i){
+            auto const ix = static_cast<std::int64_t>(std::floor(points[i].x));
+            auto const iy = static_cast<std::int64_t>(std::floor(points[i].y));
+            tiles.for_each_overlapped(ix, ix + 1, iy, iy + 1, [&](std::size_t const tile){
+                    bins.push(tile, i);
+                });
         }
+    }
 
-        fmt::print("raster with origin {:d}x{:d} and size {:d}x{:d}\n",
-            range.min_x, range.min_y, range.w(), range.h());
-
-        percent_printer progress(30, "base line");
-
-        bmp::bitmap<std::optional<raster_point>> raster_image(range.w(), range.h());
-        progress.init("create raster image", points.size());
-        for(auto const& p: points){
-            auto const printer = progress.lazy_inc();
-
-            auto& target_p = raster_image(range.x(p.rx), range.y(p.ry));
-            if(target_p){
-                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice", p.rx, p.ry));
+    /// \brief Add the corner indices of every raster quad to the bins of the tiles that contain a pixel centre of
+    ///        the bounding box of the quad
+    ///
+    /// Every quad is visited from its first present corner. Only quads with at least 3 corners are binned.
+    void bin_points(std::vector<raster_point> const& points, output_tiles const& tiles, tile_bins& bins){
+        raster_index index(points.size());
+        for(std::size_t i = 0; i < points.size(); ++i){
+            if(!index.insert(points[i].rx, points[i].ry, i)){
+                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice",
+                    points[i].rx, points[i].ry));
             }
-            target_p = p;
         }
 
-        progress.init("raster interpolation", (raster_image.h() - 1) * (raster_image.w() - 1));
-        bmp::bitmap<std::vector<raw_pixel<raster_point>>> vector_image(width, height);
-        for(std::size_t iy = 0; iy < raster_image.h() - 1; ++iy){
-            for(std::size_t ix = 0; ix < raster_image.w() - 1; ++ix){
-                auto const printer = progress.lazy_inc();
-
-                std::vector<raster_point> region;
-                region.reserve(4);
-
-                if(auto const p = raster_image(ix, iy)){
-                    region.push_back(*p);
-                }
-
-                if(auto const p = raster_image(ix + 1, iy)){
-                    region.push_back(*p);
-                }
+        for(std::size_t i = 0; i < points.size(); ++i){
+            for(std::int64_t c = 0; c < 4; ++c){
+                auto const qx = points[i].rx - (c & 1);
+                auto const qy = points[i].ry - (c >> 1);
 
-                if(auto const p = raster_image(ix, iy + 1)){
-                    region.push_back(*p);
+                std::array<std::size_t, 4> corners;
+                for(std::int64_t k = 0; k < 4; ++k){
+                    corners[static_cast<std::size_t>(k)] = index.find(qx + (k & 1), qy + (k >> 1));
                 }
 
-                if(auto const p = raster_image(ix + 1, iy + 1)){
-                    region.push_back(*p);
+                // the quad was already visited from a previous corner
+                if(std::ranges::any_of(corners.begin(), corners.begin() + c,
+                    [](std::size_t const j){ return j != raster_index::npos; })
+                ){
+                    continue;
                 }
 
-                if(region.size() < 3){
+                auto const present = std::ranges::count_if(corners,
+                    [](std::size_t const j){ return j != raster_index::npos; });
+                if(present < 3){
                     continue;
                 }
 
-                std::vector<std::array<raster_point, 3>> triangles;
-                if(region.size() == 3){
-                    triangles.reserve(1);
-                    triangles.push_back({region[0], region[1], region[2]});
-                }else{
-                    triangles.reserve(4);
-                    triangles.push_back({region[0], region[1], region[2]});
-                    triangles.push_back({region[1], region[2], region[3]});
-                    triangles.push_back({region[2], region[3], region[0]});
-                    triangles.push_back({region[3], region[0], region[1]});
-                }
-
-                for(auto const& t: triangles){
-                    // find integer bounting box around the floating point triangle within the target image
-                    auto const fx = static_cast<std::size_t>(std::clamp(static_cast<std::int64_t>(std::floor(
-                        std::min({t[0].x, t[1].x, t[2].x}))), std::int64_t(0), static_cast<std::int64_t>(width - 1)));
-                    auto const tx = static_cast<std::size_t>(std::clamp(static_cast<std::int64_t>(std::ceil(
-                        std::max({t[0].x, t[1].x, t[2].x}))), std::int64_t(0), static_cast<std::int64_t>(width - 1)));
-                    if(tx == fx){
-                        continue;
-                    }
-
-                    auto const fy = static_cast<std::size_t>(std::clamp(static_cast<std::int64_t>(std::floor(
-                        std::min({t[0].y, t[1].y, t[2].y}))), std::int64_t(0), static_cast<std::int64_t>(height - 1)));
-                    auto const ty = static_cast<std::size_t>(std::clamp(static_cast<std::int64_t>(std::ceil(
-                        std::max({t[0].y, t[1].y, t[2].y}))), std::int64_t(0), static_cast<std::int64_t>(height - 1)));
-                    if(ty == fy){
-                        continue;
-                    }
-
-                    for(std::size_t y = fy; y <= ty; ++y){
-                        for(std::size_t x = fx; x <= tx; ++x){
-                            auto const p = bmp::point<double>(static_cast<double>(x), static_cast<double>(y));
-                            if(!is_inside(t, p)){
-                                continue;
-                            }
-
-                            std::array<double, 3> const areas{{
-                                area({p, t[1], t[2]}),
-                                area({p, t[2], t[0]}),
-                                area({p, t[0], t[1]})
-                            }};
-                            auto const area_sum = areas[0] + areas[1] + areas[2];
-                            std::array<double, 3> const weight{{
-                                areas[0] / area_sum,
-                                areas[1] / area_sum,
-                                areas[2] / area_sum
-                            }};
-
-                            auto const value =
-                                t[0].v * weight[0] +
-                                t[1].v * weight[1] +
-                                t[2].v * weight[2];
-
-                            auto const index = std::max({
-                                std::pair{weight[0], std::size_t(0)},
-                                std::pair{weight[1], std::size_t(1)},
-                                std::pair{weight[2], std::size_t(2)}}).second;
-
-                            vector_image(x, y).push_back({weight[index], value, t[index].rx, t[index].ry});
-                        }
+                auto min_x = std::numeric_limits<double>::infinity();
+                auto max_x = -min_x;
+                auto min_y = min_x;
+                auto max_y = max_x;
+                for(auto const j: corners){
+                    if(j != raster_index::npos){
+                        min_x = std::min(min_x, points[j].x);
+                        max_x = std::max(max_x, points[j].x);
+                        min_y = std::min(min_y, points[j].y);
+                        max_y = std::max(max_y, points[j].y);
                     }
                 }
-            }
-        }
-
-        if constexpr(!std::same_as<RasterFilter, none_filter>){
-            // filter values via raster information
-            progress.init("reference filter", vector_image.point_count());
-            for(auto& p: vector_image){
-                auto const printer = progress.lazy_inc();
 
-                if(p.empty()){
+                // NaN gives no pixel centre
+                if(!(min_x <= max_x && min_y <= max_y)){
                     continue;
                 }
 
-                auto const iter = raster_filter(p);
-                std::erase_if(p,
-                    [ref_rx = iter->rx, ref_ry = iter->ry](raw_pixel<raster_point> const& v){
-                        return std::abs(ref_rx - v.rx) > 1 || std::abs(ref_ry - v.ry) > 1;
+                auto const to_pixel = [](double const v){
+                        return static_cast<std::int64_t>(std::clamp(v, -1e18, 1e18));
+                    };
+                tiles.for_each_overlapped(to_pixel(std::ceil(min_x)), to_pixel(std::floor(max_x)),
+                    to_pixel(std::ceil(min_y)), to_pixel(std::floor(max_y)), [&](std::size_t const tile){
+                        for(auto const j: corners){
+                            if(j != raster_index::npos){
+                                bins.push(tile, j);
+                            }
+                        }
                     });
-
             }
         }
-
-        return vector_image;
     }
 
-    template <typename Point, typename ... RasterFilter>
-    bmp::bitmap<double> to_image(
+    /// \brief Render the image tile by tile and write every tile to a BBF file as soon as it is finished
+    ///
+    /// The points are binned to the output tiles first, the bins are written to disk if they get too big. Every
+    /// tile renders its points shifted to the tile origin with the same engine as a whole image, so the memory of
+    /// the rendering is bound by the tile size. The result matches the untiled render up to the rounding of
+    /// triangles that cross a tile border.
+    template <typename Point>
+    void render_tiled(
         std::size_t const width,
         std::size_t const height,
+        std::size_t const tile_size,
         std::vector<Point> const& points,
-        RasterFilter const& ... raster_filter
+        render_options const& options,
+        std::string const& filename,
+        std::span<raster_filter const> const filters
     ){
-        using raw_pixel = ply2image::raw_pixel<Point>;
-
-        auto const vector_image = to_vector_image(width, height, points, raster_filter ...);
+        using milliseconds = std::chrono::duration<double, std::milli>;
+
+        output_tiles const tiles(width, height, tile_size);
+        tile_bins bins(tiles.count(), tile_bin_index_limit);
+
+        auto const start = std::chrono::steady_clock::now();
+        bin_points(points, tiles, bins);
+        fmt::print("binned the points into {:d}x{:d} tiles of {:d} pixels in {:.1f} ms, bins spilled to disk {:d} "
+            "times\n", tiles.columns, tiles.rows, tile_size,
+            milliseconds(std::chrono::steady_clock::now() - start).count(), bins.spill_count());
+
+        bbf_tile_writer writer(filename, width, height);
+        for(std::size_t ty = 0; ty < tiles.rows; ++ty){
+            for(std::size_t tx = 0; tx < tiles.columns; ++tx){
+                auto const x0 = tx * tile_size;
+                auto const y0 = ty * tile_size;
+                auto const tile_w = std::min(tile_size, width - x0);
+                auto const tile_h = std::min(tile_size, height - y0);
+
+                // one pixel around the tile is rendered too, so triangles crossing a tile border are clamped exactly
+                // as without tiles, where only the image border clamps
+                auto const left = x0 > 0 ? x0 - 1 : x0;
+                auto const top = y0 > 0 ? y0 - 1 : y0;
+                auto const right = std::min(x0 + tile_w + 1, width);
+                auto const bottom = std::min(y0 + tile_h + 1, height);
+
+                // sorted indices keep the order of the points, this keeps them sorted by raster y
+                auto indices = bins.read(ty * tiles.columns + tx);
+                std::ranges::sort(indices);
+                indices.erase(std::ranges::unique(indices).begin(), indices.end());
+
+                std::vector<Point> tile_points;
+                tile_points.reserve(indices.size());
+                for(auto const i: indices){
+                    auto p = points[i];
+                    p.x -= static_cast<double>(left);
+                    p.y -= static_cast<double>(top);
+                    tile_points.push_back(p);
+                }
 
-        bmp::bitmap<double> image(width, height, NaN);
-        std::ranges::transform(vector_image, image.begin(),
-            [](std::vector<raw_pixel> const& data){
-                if(data.empty()){
-                    return NaN;
-                }else [[likely]]{
-                    if(data.size() == 1){
-                        return data[0].value;
-                    }
+                if(options.verbose){
+                    fmt::print("tile {:d}x{:d} at {:d}x{:d} with {:d} points\n",
+                        tile_w, tile_h, x0, y0, tile_points.size());
+                }
 
-                    auto const sum_weight = std::transform_reduce(data.begin(), data.end(), 0., std::plus<double>{},
-                        [](raw_pixel const& v){
-                            if(v.weight < 0.){
-                                throw std::logic_error("negative weight");
-                            }
-                            return v.weight;
-                        });
-                    if(sum_weight == 0.){
-                        return NaN;
+                bmp::bitmap<double> tile(tile_w, tile_h, NaN);
+                if(!tile_points.empty()){
+                    auto const image = std::move(to_images<Point>(right - left, bottom - top, tile_points, options,
+                        nullptr, filters).front());
+                    for(std::size_t y = 0; y < tile_h; ++y){
+                        for(std::size_t x = 0; x < tile_w; ++x){
+                            tile(x, y) = image(x0 - left + x, y0 - top + y);
+                        }
                     }
-
-                    auto const value = std::transform_reduce(data.begin(), data.end(), 0., std::plus<double>{},
-                        [](raw_pixel const& v){
-                            return v.value * v.weight;
-                        });
-                    return value / sum_weight;
                 }
-            });
-
-        return image;
+                writer.write(tile, x0, y0);
+            }
+        }
     }
 
-
 }
 
 
@@ -592,6 +2047,29 @@ void print_help(argparse::ArgumentParser const& program, std::string_view const
         "foreground selection for Z values. (The smaller the value, the closer the pixel was to the acquisition "
         "system)\n"
         "\n"
+        "By default, every raster quad with 4 points is covered by its 4 overlapping triangles, so every pixel "
+        "receives 2 weighted values. The tessellation can be switched to 2 triangles per quad along a fixed diagonal, "
+        "the diagonal that is shorter in the image or the diagonal whose values differ less. This halves the "
+        "rasterization work and the stored values. The covered pixels stay the same, but every pixel is interpolated "
+        "from one triangle only, so the values differ slightly on curved surfaces and more strongly at value edges "
+        "within a quad.\n"
+        "\n"
+        "Optionally, the raster points are snapped to a fixed-point grid of subpixels and the triangle coverage is "
+        "decided with exact integer arithmetic. Pixel centres on an edge between two triangles then belong to exactly "
+        "one of them by a top-left fill rule, independent of rounding. Pixel centres exactly on the right or bottom "
+        "border of the point cloud belong to none. The snapping moves every point by at most half a subpixel.\n"
+        "\n"
+        "Next to the image, confidence planes of the raster interpolation can be output: the count of fragments per "
+        "pixel, their summed weight, the raster id of the dominant vertex and the distance to the nearest dominant "
+        "vertex. They are resolved from the same fragments as the image, either as further channels of the BBF output "
+        "or as separate BBF files.\n"
+        "\n"
+        "Very large output images can be rendered tile by tile. The points are binned to square output tiles first, "
+        "bins that grow too big are written to a temporary directory. Every tile is then rendered on its own and "
+        "written to its place in the BBF file, so the memory of the rendering depends on the tile size instead of the "
+        "image size. The result equals the untiled render up to the rounding of triangles that cross a tile border. "
+        "Tiled rendering requires BBF output.\n"
+        "\n"
         "By default, the output image is stored in BBF file format with 64-bit floating point values in the native "
         "byte order of the program's current execution environment. Empty pixels are encoded as NaN (Not a Number). "
         "The BBF specification is linked above. It is a simple raw data format with a 24 bytes header.\n"
@@ -669,8 +2147,15 @@ int main(int argc, char** argv)try{
         .help("the PLY element property used as y image position (must not be a list type)")
         .default_value("y"s);
     program.add_argument("-v", "--value-property")
-        .help("the PLY element property converted to image values (must not be a list type)")
-        .default_value("z"s);
+        .help("the PLY element properties converted to image values (must not be a list type), several properties "
+            "are rendered in one run with the same weights and raster filter references as the first one, this "
+            "requires the engine streaming and gives one channel per property in the BBF output")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>{"z"});
+    program.add_argument("--split-values")
+        .help("write every additional value property to a separate file next to the output with the property name "
+            "before the extension instead of a multi-channel BBF output")
+        .flag();
 
     program.add_argument("--x-raster-property")
         .help("the PLY element property used as x raster position (must not be a list type)")
@@ -680,14 +2165,100 @@ int main(int argc, char** argv)try{
         .default_value("raster_y"s);
 
     program.add_argument("--raster-filter")
-        .help(fmt::format("raster filter {:s}", valid_values_string(raster_filter_strings)))
-        .default_value(std::string(raster_filter_strings[0]));
+        .help(fmt::format("raster filters, several filters are resolved from the same fragments and every further "
+            "filter is written to a separate file next to the output with the filter name before the extension {:s}",
+            valid_values_string(raster_filter_strings)))
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>{std::string(raster_filter_strings[0])});
 
     program.add_argument("--disable-raster")
         .help("explicitly disable gap interpolation via raster")
         .implicit_value(true)
         .default_value(false);
 
+    program.add_argument("--engine")
+        .help(fmt::format("fragment storage of the raster interpolation, \"vector\" keeps one list per pixel, "
+            "\"csr\" counts the fragments first and fills one contiguous array, \"streaming\" stores no fragments "
+            "and rasterizes twice, first to find the raster filter reference, then to accumulate {:s}",
+            valid_values_string(render_engine_strings)))
+        .default_value(std::string(render_engine_strings[0]));
+
+    program.add_argument("--threads")
+        .help("count of worker threads for the raster interpolation, 0 uses all hardware threads")
+        .scan<'u', std::size_t>()
+        .default_value(std::size_t(0));
+
+    program.add_argument("--verbose")
+        .help("print diagnostics of the render engine, e.g. the load of every worker thread or the point count "
+            "of every output tile")
+        .flag();
+
+    program.add_argument("--sorted-raster")
+        .help("the points are sorted by raster y, only two raster rows are kept in memory instead of the whole raster "
+            "image")
+        .implicit_value(true)
+        .default_value(false);
+
+    program.add_argument("--compact-fragments")
+        .help("the csr engine stores every fragment in 16 instead of 32 bytes with single precision weight and value "
+            "and 32 bit raster ids, falls back to the wide format if the raster ids or values do not fit")
+        .implicit_value(true)
+        .default_value(false);
+
+    program.add_argument("--max-fragments-per-pixel")
+        .help("the vector engine keeps at most this many fragments per pixel, the ones with the lowest values for "
+            "the raster filter min, the highest values for max and the highest weights without filter, the count of "
+            "pixels that reach the limit is printed, the raster interpolation then runs on one thread, 0 keeps all "
+            "fragments")
+        .scan<'u', std::size_t>()
+        .default_value(std::size_t(0));
+
+    program.add_argument("--simd")
+        .help(fmt::format("instruction set of the triangle span kernel, all give identical results, \"auto\" picks "
+            "the widest one the CPU supports {:s}", valid_values_string(simd_level_strings)))
+        .default_value(std::string(simd_level_strings[0]));
+
+    program.add_argument("--tessellation")
+        .help(fmt::format("triangulation of raster quads with 4 points, \"four\" uses 4 overlapping triangles, the "
+            "other modes split the quad into 2 triangles along the diagonal from the upper right to the lower left "
+            "point (\"fixed\"), the diagonal that is shorter in the image (\"shorter\") or the diagonal whose "
+            "values differ less (\"depth\") {:s}", valid_values_string(quad_tessellation_strings)))
+        .default_value(std::string(quad_tessellation_strings[0]));
+
+    program.add_argument("--subpixel-bits")
+        .help("snap the raster points to a fixed-point grid with subpixel-bits fractional bits, e.g. 8, and decide "
+            "the triangle coverage with exact integer edge functions and a top-left fill rule, at most 16, 0 "
+            "rasterizes in floating point")
+        .scan<'u', std::size_t>()
+        .default_value(std::size_t(0));
+
+    program.add_argument("--mapped-output")
+        .help("create the BBF output file with its final size first and resolve the pixels directly into a memory "
+            "mapping of it instead of copying the finished image, requires BBF output")
+        .flag();
+
+    program.add_argument("--output-sync")
+        .help(fmt::format("flush the mapped output to disk before exit, \"msync\" writes the mapped pages back, "
+            "\"fdatasync\" also syncs the file size, \"none\" leaves it to the operating system, requires "
+            "--mapped-output {:s}", valid_values_string(output_sync_strings)))
+        .default_value(std::string(output_sync_strings[0]));
+
+    program.add_argument("--tile-size")
+        .help("render the image in square tiles of tile-size pixels and write every tile as soon as it is finished, "
+            "the memory of the rendering is bound by the tile size instead of the image size, requires BBF output, "
+            "0 renders the whole image at once")
+        .scan<'u', std::size_t>()
+        .default_value(std::size_t(0));
+
+    program.add_argument("--aux-planes")
+        .help(fmt::format("also output the planes count (fragments per pixel), weight (summed weight), rx and ry "
+            "(raster id of the dominant vertex) and dominant_distance (to the nearest dominant vertex in pixels) of "
+            "the raster interpolation, as channels 2 to 6 of the BBF output (\"channels\") or as separate BBF files "
+            "next to the output with the plane name before the extension (\"files\"), requires the engine vector or "
+            "csr {:s}",
+            valid_values_string(aux_output_strings)))
+        .default_value(std::string(aux_output_strings[0]));
+
     program.add_argument("--x-scale")
         .help("all x values are multiplied by x-scale")
         .scan<'g', double>()
@@ -759,7 +2330,9 @@ int main(int argc, char** argv)try{
 
     auto const x_property = program.get<std::string>("-x");
     auto const y_property = program.get<std::string>("-y");
-    auto const v_property = program.get<std::string>("-v");
+    auto const v_properties = program.get<std::vector<std::string>>("-v");
+    auto const& v_property = v_properties.front();
+    auto const split_values = program.get<bool>("--split-values");
 
     auto const arg_xr_element = get_raster<std::string>(program, "--x-raster-element", "--disable-raster");
     auto const arg_yr_element = get_raster<std::string>(program, "--y-raster-element", "--disable-raster");
@@ -770,8 +2343,90 @@ int main(int argc, char** argv)try{
         program.is_used("--y-raster-element") ||
         program.is_used("--x-raster-property") ||
         program.is_used("--y-raster-property");
-    auto const filter =
-        parse_enum_string<raster_filter>(raster_filter_strings, program.get<std::string>("--raster-filter"));
+    auto const filters = [&]{
+            std::vector<raster_filter> result;
+            for(auto const& name: program.get<std::vector<std::string>>("--raster-filter")){
+                result.push_back(parse_enum_string<raster_filter>(raster_filter_strings, name));
+            }
+            return result;
+        }();
+
+    render_options const options{
+        .engine = parse_enum_string<render_engine>(render_engine_strings, program.get<std::string>("--engine")),
+        .threads = program.get<std::size_t>("--threads"),
+        .verbose = program.get<bool>("--verbose"),
+        .sorted_raster = program.get<bool>("--sorted-raster"),
+        .simd = parse_enum_string<simd_level>(simd_level_strings, program.get<std::string>("--simd")),
+        .tessellation = parse_enum_string<quad_tessellation>(quad_tessellation_strings,
+            program.get<std::string>("--tessellation")),
+        .subpixel_bits = program.get<std::size_t>("--subpixel-bits"),
+        .compact_fragments = program.get<bool>("--compact-fragments"),
+        .max_fragments_per_pixel = program.get<std::size_t>("--max-fragments-per-pixel"),
+    };
+
+    if(options.max_fragments_per_pixel > 0 && options.engine != render_engine::vector){
+        throw std::runtime_error("--max-fragments-per-pixel requires the engine vector");
+    }
+
+    if(options.max_fragments_per_pixel > 0 && options.threads > 1){
+        throw std::runtime_error("--max-fragments-per-pixel rasterizes on one thread, it requires --threads 0 or 1");
+    }
+
+    auto const tile_size = program.get<std::size_t>("--tile-size");
+    if(tile_size > 0 && output_format != file_format::bbf){
+        throw std::runtime_error("--tile-size requires the output format bbf");
+    }
+
+    auto const aux_mode = parse_enum_string<aux_output>(aux_output_strings, program.get<std::string>("--aux-planes"));
+    if(aux_mode != aux_output::none){
+        if(options.engine == render_engine::streaming){
+            throw std::runtime_error("--aux-planes requires the engine vector or csr");
+        }else if(tile_size > 0){
+            throw std::runtime_error("--aux-planes can not be combined with --tile-size");
+        }else if(aux_mode == aux_output::channels && output_format != file_format::bbf){
+            throw std::runtime_error("--aux-planes channels requires the output format bbf");
+        }
+    }
+
+    auto const mapped_output = program.get<bool>("--mapped-output");
+    auto const sync = parse_enum_string<output_sync>(output_sync_strings, program.get<std::string>("--output-sync"));
+    if(sync != output_sync::none && !mapped_output){
+        throw std::runtime_error("--output-sync requires --mapped-output");
+    }
+
+    if(mapped_output){
+        if(output_format != file_format::bbf){
+            throw std::runtime_error("--mapped-output requires the output format bbf");
+        }else if(tile_size > 0){
+            throw std::runtime_error("--mapped-output can not be combined with --tile-size");
+        }else if(aux_mode != aux_output::none){
+            throw std::runtime_error("--mapped-output can not be combined with --aux-planes");
+        }else if(filters.size() > 1 || v_properties.size() > 1){
+            throw std::runtime_error("--mapped-output supports only one raster filter and value property");
+        }
+    }
+
+    if(filters.size() > 1){
+        if(tile_size > 0){
+            throw std::runtime_error("several raster filters can not be combined with --tile-size");
+        }else if(aux_mode != aux_output::none){
+            throw std::runtime_error("several raster filters can not be combined with --aux-planes");
+        }else if(options.max_fragments_per_pixel > 0){
+            throw std::runtime_error("several raster filters can not be combined with --max-fragments-per-pixel");
+        }else if(v_properties.size() > 1){
+            throw std::runtime_error("several raster filters can not be combined with several value properties");
+        }
+    }
+
+    if(v_properties.size() > 1){
+        if(options.engine != render_engine::streaming){
+            throw std::runtime_error("several value properties require the engine streaming");
+        }else if(tile_size > 0){
+            throw std::runtime_error("several value properties can not be combined with --tile-size");
+        }else if(!split_values && output_format != file_format::bbf){
+            throw std::runtime_error("several value properties require the output format bbf or --split-values");
+        }
+    }
 
     auto const x_scale = program.get<double>("--x-scale");
     auto const y_scale = program.get<double>("--y-scale");
@@ -801,7 +2456,10 @@ int main(int argc, char** argv)try{
     // display file structure
     {
         auto used_properties = std::vector<std::array<std::string_view, 2>>{
-            {x_element, x_property}, {y_element, y_property}, {v_element, v_property}};
+            {x_element, x_property}, {y_element, y_property}};
+        for(auto const& property: v_properties){
+            used_properties.push_back({v_element, property});
+        }
 
         if(arg_xr_element){
             used_properties.push_back({*arg_xr_element, *arg_xr_property});
@@ -890,8 +2548,26 @@ int main(int argc, char** argv)try{
         throw std::runtime_error("value count is 0");
     }
 
+    std::vector<bmp::bitmap<double>> value_images;
+    std::vector<bmp::bitmap<double>> filter_images;
+
+    std::optional<aux_planes> aux;
+    if(aux_mode != aux_output::none){
+        aux.emplace(width, height);
+    }
+
     auto const image_convert =
-        [&]<typename Point>(std::type_identity<Point>, auto const& ... raster_filter){
+        [&]<typename Point>(std::type_identity<Point>){
+            if constexpr(std::is_same_v<Point, point>){
+                if(aux){
+                    throw std::runtime_error("--aux-planes requires raster interpolation");
+                }else if(v_properties.size() > 1){
+                    throw std::runtime_error("several value properties require raster interpolation");
+                }else if(filters.size() > 1){
+                    throw std::runtime_error("several raster filters require raster interpolation");
+                }
+            }
+
             // extract used data
             std::vector<Point> points(count);
             auto const convert = [&points]<ply::valid_value T>(auto const& setter, std::span<T const> const list){
@@ -924,50 +2600,150 @@ int main(int argc, char** argv)try{
                 std::visit([=](auto const& v){ convert(set_ry, v); }, data.values(*yr_element, *yr_property));
             }
 
+            // additional value properties by raster id, they are converted like the first one
+            std::optional<raster_values> values;
+            if constexpr(std::is_same_v<Point, raster_point>){
+                if(v_properties.size() > 1){
+                    std::vector<std::vector<double>> channels;
+                    for(auto const& property: std::span(v_properties).subspan(1)){
+                        auto& channel = channels.emplace_back(count);
+                        std::visit([&]<ply::valid_value T>(std::span<T const> const list){
+                                if constexpr(ply::scalar_value<T>)[[likely]]{
+                                    for(std::size_t i = 0; i < channel.size(); ++i){
+                                        channel[i] = (static_cast<double>(list[i]) + v_pre_scale) * v_scale +
+                                            v_post_scale;
+                                    }
+                                }else{
+                                    throw std::runtime_error("list type properties are not supported");
+                                }
+                            }, data.values(v_element, property));
+                    }
+                    values.emplace(points, channels);
+                }
+            }
+
+            // remove points that can not contribute to the target image
+            auto const culled = [&]{
+                    if constexpr(std::is_same_v<Point, raster_point>){
+                        if(options.sorted_raster){
+                            return cull_sorted_points(width, height, points);
+                        }
+                    }
+                    return cull_points(width, height, points);
+                }();
+            fmt::print("culled {:d} of {:d} points outside of the target image\n", culled, count);
+
+            if(tile_size > 0){
+                render_tiled<Point>(width, height, tile_size, points, options, output_filepath.string(), filters);
+                return std::optional<bmp::bitmap<double>>();
+            }
+
+            if(mapped_output){
+                bbf_mapped_image output(output_filepath.string(), width, height);
+                auto const view = output.view();
+                render_images<Point>(std::span(&view, 1), points, options, nullptr, filters);
+                output.finish(sync);
+                return std::optional<bmp::bitmap<double>>();
+            }
+
             // convert list to image
-            return to_image<Point>(width, height, points, raster_filter ...);
+            if constexpr(std::is_same_v<Point, raster_point>){
+                if(values){
+                    bmp::bitmap<double> image(width, height);
+                    bitmap_view const view(image);
+                    render_streaming(std::span(&view, 1), points, options, filters, &*values, &value_images);
+                    return std::optional(std::move(image));
+                }
+            }
+
+            // the images of further raster filters are written beside the first one
+            auto images = to_images<Point>(width, height, points, options, aux ? &*aux : nullptr, filters);
+            filter_images.assign(std::make_move_iterator(images.begin() + 1), std::make_move_iterator(images.end()));
+            return std::optional(std::move(images.front()));
         };
 
     auto const image =
         [&]{
             if(xr_element){
-                switch(filter){
-                    case raster_filter::min:
-                        return image_convert(std::type_identity<raster_point>(), min_value_filter{});
-                    case raster_filter::max:
-                        return image_convert(std::type_identity<raster_point>(), max_value_filter{});
-                    case raster_filter::none:
-                        return image_convert(std::type_identity<raster_point>(), none_filter{});
-                }
-                throw std::logic_error("invalid raster filter");
+                return image_convert(std::type_identity<raster_point>());
             }else{
                 return image_convert(std::type_identity<point>());
             }
         }();
 
-    [&]{
-        switch(output_format){
-            case file_format::bbf: {
-                bmp::binary_write(image, output_filepath.string());
-            } return;
-            case file_format::png: {
-                bmp::bitmap<bmp::pixel::masked_g16u> png_image(image.size());
-                std::ranges::transform(image, png_image.begin(),
-                    [](double const v){
-                        if(std::isnan(v)){
-                            return bmp::pixel::masked_g16u{.v = {}, .m = true};
-                        }else{
-                            return bmp::pixel::masked_g16u{
-                                .v = static_cast<std::uint16_t>(std::round(std::clamp(v, 0., 65535.))), .m = false};
-                        }
-                    });
+    // the tiled and the mapped render have written the image already
+    if(!image){
+        return 0;
+    }
+
+    auto const write_image = [output_format](bmp::bitmap<double> const& image, std::string const& path){
+            switch(output_format){
+                case file_format::bbf: {
+                    bmp::binary_write(image, path);
+                } return;
+                case file_format::png: {
+                    bmp::bitmap<bmp::pixel::masked_g16u> png_image(image.size());
+                    std::ranges::transform(image, png_image.begin(),
+                        [](double const v){
+                            if(std::isnan(v)){
+                                return bmp::pixel::masked_g16u{.v = {}, .m = true};
+                            }else{
+                                return bmp::pixel::masked_g16u{
+                                    .v = static_cast<std::uint16_t>(std::round(std::clamp(v, 0., 65535.))),
+                                    .m = false};
+                            }
+                        });
+
+                    bmp::png::write(png_image, path);
+                } return;
+            }
+
+            throw std::logic_error("invalid file format");
+        };
 
-                bmp::png::write(png_image, output_filepath.string());
-            } return;
+    if(aux_mode == aux_output::channels || (!value_images.empty() && !split_values)){
+        // the value properties first, then the auxiliary planes
+        std::vector<bmp::bitmap<double> const*> channels{&*image};
+        if(!split_values){
+            for(auto const& value_image: value_images){
+                channels.push_back(&value_image);
+            }
         }
 
-        throw std::logic_error("invalid file format");
-    }();
+        if(aux_mode == aux_output::channels){
+            for(auto const& plane: aux->planes){
+                channels.push_back(&plane);
+            }
+        }
+
+        write_bbf_channels(output_filepath.string(), channels);
+    }else{
+        write_image(*image, output_filepath.string());
+    }
+
+    auto const write_beside = [&](bmp::bitmap<double> const& image, std::string_view const name){
+            auto const path = output_filepath.parent_path() / fmt::format("{:s}.{:s}{:s}",
+                output_filepath.stem().string(), name, output_filepath.extension().string());
+            write_image(image, path.string());
+        };
+
+    if(split_values){
+        for(std::size_t i = 0; i < value_images.size(); ++i){
+            write_beside(value_images[i], v_properties[i + 1]);
+        }
+    }
+
+    for(std::size_t i = 0; i < filter_images.size(); ++i){
+        write_beside(filter_images[i], raster_filter_strings[static_cast<int>(filters[i + 1])]);
+    }
+
+    if(aux_mode == aux_output::files){
+        for(std::size_t i = 0; i < aux_planes::names.size(); ++i){
+            auto const path = output_filepath.parent_path() /
+                fmt::format("{:s}.{:s}.bbf", output_filepath.stem().string(), aux_planes::names[i]);
+            bmp::binary_write(aux->planes[i], path.string());
+        }
+    }
 }catch(std::system_error const& error){
     fmt::print(fmt::emphasis::bold | fg(fmt::color::red),
         "System error:\n"
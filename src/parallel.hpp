@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Resolve a requested thread count, 0 stands for the hardware concurrency
+    inline std::size_t thread_count(std::size_t const threads)noexcept{
+        if(threads != 0){
+            return threads;
+        }
+
+        return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    /// \brief Call f(i) for all i in [0, count) on up to threads threads
+    ///
+    /// The indices are handed out dynamically, so the result of f must not depend on the thread that runs it. The
+    /// calling thread takes part in the work. The first exception thrown by f is rethrown after all threads
+    /// finished, the remaining indices are skipped.
+    template <typename F>
+    void parallel_for(std::size_t const count, std::size_t const threads, F const& f){
+        if(threads <= 1 || count <= 1){
+            for(std::size_t i = 0; i < count; ++i){
+                f(i);
+            }
+            return;
+        }
+
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto const worker = [&]{
+                for(auto i = next++; i < count; i = next++){
+                    try{
+                        f(i);
+                    }catch(...){
+                        std::lock_guard lock(error_mutex);
+                        if(!error){
+                            error = std::current_exception();
+                        }
+                        next = count;
+                    }
+                }
+            };
+
+        {
+            std::vector<std::jthread> pool;
+            pool.reserve(std::min(threads, count) - 1);
+            for(std::size_t i = 1; i < std::min(threads, count); ++i){
+                pool.emplace_back(worker);
+            }
+            worker();
+        }
+
+        if(error){
+            std::rethrow_exception(error);
+        }
+    }
+
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "raster_point.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+
+namespace ply2image{
+
+
+    /// \brief Triangles of a raster quad as corner indices
+    ///
+    /// Corner 0 is (ix, iy), 1 is (ix + 1, iy), 2 is (ix, iy + 1) and 3 is (ix + 1, iy + 1).
+    struct quad_triangulation{
+        std::uint8_t count;
+        std::array<std::array<std::uint8_t, 3>, 4> triangles;
+    };
+
+    /// \brief Triangulation for every 4 bit corner occupancy mask of a quad
+    ///
+    /// Quads with 3 corners form one triangle, full quads form the 4 overlapping triangles
+    /// {0, 1, 2}, {1, 2, 3}, {2, 3, 0} and {3, 0, 1}. All other quads are empty.
+    inline constexpr auto quad_triangulations = []{
+        std::array<quad_triangulation, 16> result{};
+        for(std::uint8_t mask = 0; mask < 16; ++mask){
+            std::array<std::uint8_t, 4> corners{};
+            std::uint8_t count = 0;
+            for(std::uint8_t c = 0; c < 4; ++c){
+                if((mask >> c) & 1){
+                    corners[count++] = c;
+                }
+            }
+
+            auto& entry = result[mask];
+            if(count == 3){
+                entry.count = 1;
+                entry.triangles[0] = {corners[0], corners[1], corners[2]};
+            }else if(count == 4){
+                entry.count = 4;
+                entry.triangles[0] = {0, 1, 2};
+                entry.triangles[1] = {1, 2, 3};
+                entry.triangles[2] = {2, 3, 0};
+                entry.triangles[3] = {3, 0, 1};
+            }
+        }
+        return result;
+    }();
+
+
+    /// \brief Triangulation of full quads
+    enum class quad_tessellation{
+        /// \brief The 4 overlapping triangles of quad_triangulations, every pixel is covered twice
+        four = 0,
+
+        /// \brief 2 triangles split along the diagonal from corner 1 to corner 2
+        fixed = 1,
+
+        /// \brief 2 triangles split along the diagonal that is shorter in the image
+        shorter = 2,
+
+        /// \brief 2 triangles split along the diagonal whose corner values differ less
+        depth = 3
+    };
+
+    /// \brief Full quad split along the diagonal from corner 1 to corner 2, the first 2 triangles of the 4
+    inline constexpr quad_triangulation quad_split_1_2{2, {{{0, 1, 2}, {1, 2, 3}}}};
+
+    /// \brief Full quad split along the diagonal from corner 0 to corner 3, the last 2 triangles of the 4
+    inline constexpr quad_triangulation quad_split_0_3{2, {{{2, 3, 0}, {3, 0, 1}}}};
+
+    /// \brief Triangulation of a quad with the 4 bit corner occupancy mask and the corners
+    ///
+    /// Only full quads depend on the tessellation. On equal diagonals and for NaN the split from corner 1 to
+    /// corner 2 is used.
+    inline quad_triangulation const& triangulate_quad(
+        std::uint8_t const occupancy,
+        std::array<raster_point, 4> const& corners,
+        quad_tessellation const tessellation
+    )noexcept{
+        if(occupancy != 0xF || tessellation == quad_tessellation::four){
+            return quad_triangulations[occupancy];
+        }
+
+        auto const split_0_3 = [&]{
+                switch(tessellation){
+                    case quad_tessellation::shorter:{
+                        auto const length2 = [&](std::size_t const a, std::size_t const b){
+                                auto const dx = corners[a].x - corners[b].x;
+                                auto const dy = corners[a].y - corners[b].y;
+                                return dx * dx + dy * dy;
+                            };
+                        return length2(0, 3) < length2(1, 2);
+                    }
+                    case quad_tessellation::depth:
+                        return std::abs(corners[0].v - corners[3].v) < std::abs(corners[1].v - corners[2].v);
+                    default:
+                        return false;
+                }
+            }();
+
+        return split_0_3 ? quad_split_0_3 : quad_split_1_2;
+    }
+
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "raster_point.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    struct raster_range{
+        std::int64_t min_x;
+        std::int64_t max_x;
+        std::int64_t min_y;
+        std::int64_t max_y;
+
+        std::size_t w()const{
+            return static_cast<std::size_t>(max_x + 1 - min_x);
+        }
+
+        std::size_t h()const{
+            return static_cast<std::size_t>(max_y + 1 - min_y);
+        }
+
+        std::size_t x(std::int64_t const x)const{
+            return static_cast<std::size_t>(x - min_x);
+        }
+
+        std::size_t y(std::int64_t const y)const{
+            return static_cast<std::size_t>(y - min_y);
+        }
+    };
+
+    inline raster_range find_raster_range(std::vector<raster_point> const& points){
+        using limits = std::numeric_limits<std::int64_t>;
+        raster_range range{limits::max(), limits::min(), limits::max(), limits::min()};
+        for(auto const& p: points){
+            range.min_x = std::min(range.min_x, p.rx);
+            range.max_x = std::max(range.max_x, p.rx);
+            range.min_y = std::min(range.min_y, p.ry);
+            range.max_y = std::max(range.max_y, p.ry);
+        }
+        return range;
+    }
+
+
+    /// \brief Bitmask of the quads with at least 3 occupied corners from the validity words of two rows
+    ///
+    /// top and bottom are the words of the upper and the lower row, top_next and bottom_next the following words
+    /// of the same rows. Bit i stands for the quad with its upper left corner at bit i of top.
+    constexpr std::uint64_t quad_bits(
+        std::uint64_t const top,
+        std::uint64_t const bottom,
+        std::uint64_t const top_next,
+        std::uint64_t const bottom_next
+    )noexcept{
+        // shift the right neighbours onto the bit of their quad
+        auto const top_right = (top >> 1) | (top_next << 63);
+        auto const bottom_right = (bottom >> 1) | (bottom_next << 63);
+
+        return (top & top_right & (bottom | bottom_right)) | (bottom & bottom_right & (top | top_right));
+    }
+
+
+    /// \brief Dense raster of points in structure of arrays layout
+    ///
+    /// The x, y and v values are stored in separate planes, the raster position is implied by the cell. Occupied
+    /// cells are marked in a packed bitmask with one 64 bit word per 64 cells of a row.
+    class raster_grid{
+    public:
+        /// \brief Count of cells per mask word
+        static constexpr std::size_t word_bits = 64;
+
+        raster_grid(raster_range const& range)
+            : range_(range)
+            , w_(range.w())
+            , h_(range.h())
+            , words_((w_ + word_bits - 1) / word_bits)
+            , x_(w_ * h_)
+            , y_(w_ * h_)
+            , v_(w_ * h_)
+            , valid_(words_ * h_) {}
+
+        std::size_t w()const noexcept{
+            return w_;
+        }
+
+        std::size_t h()const noexcept{
+            return h_;
+        }
+
+        raster_range const& range()const noexcept{
+            return range_;
+        }
+
+        /// \brief Count of mask words per row
+        std::size_t words()const noexcept{
+            return words_;
+        }
+
+        /// \brief Insert a point at its raster position
+        ///
+        /// \throw std::runtime_error if the cell is already occupied
+        void insert(raster_point const& p){
+            auto const ix = range_.x(p.rx);
+            auto const iy = range_.y(p.ry);
+            auto& word = valid_[iy * words_ + ix / word_bits];
+            auto const bit = std::uint64_t(1) << (ix % word_bits);
+            if(word & bit){
+                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice", p.rx, p.ry));
+            }
+            word |= bit;
+
+            auto const i = iy * w_ + ix;
+            x_[i] = p.x;
+            y_[i] = p.y;
+            v_[i] = p.v;
+        }
+
+        bool contains(std::size_t const ix, std::size_t const iy)const noexcept{
+            return (valid_[iy * words_ + ix / word_bits] >> (ix % word_bits)) & 1;
+        }
+
+        /// \brief 4 bit occupancy mask of the quad with its upper left corner in cell (ix, iy)
+        ///
+        /// Bit 0 is (ix, iy), bit 1 is (ix + 1, iy), bit 2 is (ix, iy + 1) and bit 3 is (ix + 1, iy + 1).
+        std::uint8_t occupancy(std::size_t const ix, std::size_t const iy)const noexcept{
+            return static_cast<std::uint8_t>(
+                (contains(ix, iy) ? 0x1 : 0x0) |
+                (contains(ix + 1, iy) ? 0x2 : 0x0) |
+                (contains(ix, iy + 1) ? 0x4 : 0x0) |
+                (contains(ix + 1, iy + 1) ? 0x8 : 0x0));
+        }
+
+        /// \brief Assemble the point of an occupied cell
+        raster_point operator()(std::size_t const ix, std::size_t const iy)const noexcept{
+            auto const i = iy * w_ + ix;
+            return {
+                x_[i], y_[i], v_[i],
+                range_.min_x + static_cast<std::int64_t>(ix),
+                range_.min_y + static_cast<std::int64_t>(iy)};
+        }
+
+        /// \brief Move every row one up, the last row becomes empty and the raster origin moves one row down
+        void shift_rows()noexcept{
+            auto const cells = static_cast<std::ptrdiff_t>(w_);
+            for(auto* plane: {&x_, &y_, &v_}){
+                std::copy(plane->begin() + cells, plane->end(), plane->begin());
+            }
+
+            auto const words = static_cast<std::ptrdiff_t>(words_);
+            std::copy(valid_.begin() + words, valid_.end(), valid_.begin());
+            std::fill(valid_.end() - words, valid_.end(), 0);
+
+            ++range_.min_y;
+            ++range_.max_y;
+        }
+
+        /// \brief Validity bits of the cells word * 64 to word * 64 + 63 in row iy
+        std::uint64_t mask(std::size_t const word, std::size_t const iy)const noexcept{
+            return valid_[iy * words_ + word];
+        }
+
+        /// \brief Bitmask of the quads with at least 3 occupied corners
+        ///
+        /// Bit i stands for the quad with its upper left corner in cell (word * 64 + i, iy). Fully empty runs of
+        /// both rows are rejected by the mask words alone.
+        std::uint64_t quad_mask(std::size_t const word, std::size_t const iy)const noexcept{
+            auto const top = mask(word, iy);
+            auto const bottom = mask(word, iy + 1);
+            if((top | bottom) == 0){
+                return 0;
+            }
+
+            auto const next = word + 1 < words_;
+            return quad_bits(top, bottom, next ? mask(word + 1, iy) : 0, next ? mask(word + 1, iy + 1) : 0);
+        }
+
+        /// \brief Call f(word, quads) for every word of row iy with a nonzero quad_mask in ascending order
+        template <typename F>
+        void for_each_quad_word(std::size_t const iy, F&& f)const{
+            for(std::size_t word = 0; word < words_; ++word){
+                if(auto const quads = quad_mask(word, iy); quads != 0){
+                    f(word, quads);
+                }
+            }
+        }
+
+    private:
+        raster_range range_;
+        std::size_t w_;
+        std::size_t h_;
+        std::size_t words_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        std::vector<double> v_;
+        std::vector<std::uint64_t> valid_;
+    };
+
+
+}
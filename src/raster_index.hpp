@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Open addressing hash map from raster positions to indices
+    ///
+    /// The slots are probed linearly and the table is kept at most half full, so find and insert take constant
+    /// time on average independent of the extent of the raster positions.
+    class raster_index{
+    public:
+        /// \brief Index of positions that are not in the map
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        explicit raster_index(std::size_t const expected_size = 0){
+            rehash(std::bit_ceil(std::max<std::size_t>(expected_size * 2, 16)));
+        }
+
+        std::size_t size()const noexcept{
+            return size_;
+        }
+
+        /// \brief Index stored for position (x, y) or npos
+        std::size_t find(std::int64_t const x, std::int64_t const y)const noexcept{
+            for(auto i = hash(x, y) & mask_;; i = (i + 1) & mask_){
+                auto const& s = slots_[i];
+                if(s.index == npos || (s.x == x && s.y == y)){
+                    return s.index;
+                }
+            }
+        }
+
+        /// \brief Store index for position (x, y)
+        ///
+        /// \return false if the position was already in the map, the stored index is not changed then
+        bool insert(std::int64_t const x, std::int64_t const y, std::size_t const index){
+            if((size_ + 1) * 2 > slots_.size()){
+                rehash(slots_.size() * 2);
+            }
+
+            for(auto i = hash(x, y) & mask_;; i = (i + 1) & mask_){
+                auto& s = slots_[i];
+                if(s.index == npos){
+                    s = {x, y, index};
+                    ++size_;
+                    return true;
+                }
+
+                if(s.x == x && s.y == y){
+                    return false;
+                }
+            }
+        }
+
+    private:
+        struct slot{
+            std::int64_t x;
+            std::int64_t y;
+            std::size_t index;
+        };
+
+        static std::size_t hash(std::int64_t const x, std::int64_t const y)noexcept{
+            auto h = static_cast<std::uint64_t>(x) * 0x9E3779B97F4A7C15 ^
+                static_cast<std::uint64_t>(y) * 0xC2B2AE3D27D4EB4F;
+            h ^= h >> 29;
+            return static_cast<std::size_t>(h);
+        }
+
+        void rehash(std::size_t const capacity){
+            std::vector<slot> old(capacity, slot{0, 0, npos});
+            old.swap(slots_);
+            mask_ = capacity - 1;
+            size_ = 0;
+            for(auto const& s: old){
+                if(s.index != npos){
+                    insert(s.x, s.y, s.index);
+                }
+            }
+        }
+
+        std::vector<slot> slots_;
+        std::size_t mask_ = 0;
+        std::size_t size_ = 0;
+    };
+
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "bitmap/point.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+
+namespace ply2image{
+
+
+    struct point{
+        double x;
+        double y;
+        double v;
+    };
+
+    struct raster_point{
+        double x;
+        double y;
+        double v;
+        std::int64_t rx;
+        std::int64_t ry;
+
+        operator bmp::point<double>()const{
+            return {x, y};
+        };
+    };
+
+    template <typename Point>
+    struct raw_pixel;
+
+    template <>
+    struct raw_pixel<point>{
+        double weight;
+        double value;
+    };
+
+    template <>
+    struct raw_pixel<raster_point>{
+        double weight;
+        double value;
+        std::int64_t rx;
+        std::int64_t ry;
+    };
+
+    /// \brief Fragment of raw_pixel<raster_point> in 16 instead of 32 bytes
+    ///
+    /// Weight and value are stored in single precision, the raster ids in 32 bit.
+    struct compact_raster_pixel{
+        float weight;
+        float value;
+        std::int32_t rx;
+        std::int32_t ry;
+    };
+
+    /// \brief Convert a fragment of the rasterizer to the storage format Fragment
+    ///
+    /// For compact_raster_pixel the raster ids must fit into 32 bit and the value into single precision.
+    template <typename Fragment>
+    constexpr Fragment store_fragment(raw_pixel<raster_point> const& fragment)noexcept{
+        if constexpr(std::is_same_v<Fragment, compact_raster_pixel>){
+            return {
+                static_cast<float>(fragment.weight),
+                static_cast<float>(fragment.value),
+                static_cast<std::int32_t>(fragment.rx),
+                static_cast<std::int32_t>(fragment.ry)};
+        }else{
+            return fragment;
+        }
+    }
+
+
+}
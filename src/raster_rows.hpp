@@ -0,0 +1,272 @@
+#pragma once
+
+#include "quad_triangulation.hpp"
+#include "raster_grid.hpp"
+#include "triangle_rasterizer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Count of raster quads per setup path
+    struct quad_path_counts{
+        /// \brief Quads whose bounding box contains no pixel centre of the target image
+        std::size_t empty = 0;
+
+        /// \brief Quads whose bounding box contains exactly one pixel centre
+        std::size_t single = 0;
+
+        /// \brief Quads that are rasterized with the span kernel
+        std::size_t full = 0;
+
+        quad_path_counts& operator+=(quad_path_counts const& other)noexcept{
+            empty += other.empty;
+            single += other.single;
+            full += other.full;
+            return *this;
+        }
+    };
+
+
+    /// \brief Set up the triangles of all quads with their upper left corner in raster row iy
+    ///
+    /// Grid is raster_grid or sparse_raster_grid. Every quad is classified by the pixel centres in its bounding
+    /// box first. Quads without one are dropped, quads with exactly one evaluate their triangles only at this
+    /// pixel and all other quads set up their triangles for the span kernel. Full quads are triangulated by
+    /// triangulate_quad. All corners are snapped to the fixed-point grid of the batch first.
+    ///
+    /// \return the count of quads per setup path
+    template <typename Grid>
+    quad_path_counts setup_raster_row(
+        Grid const& raster_image,
+        std::size_t const iy,
+        std::size_t const width,
+        std::size_t const height,
+        quad_tessellation const tessellation,
+        triangle_batch& batch
+    ){
+        quad_path_counts counts;
+        auto const bits = batch.subpixel_bits();
+        batch.clear();
+        raster_image.for_each_quad_word(iy, [&](std::size_t const word, std::uint64_t quads){
+                for(; quads != 0; quads &= quads - 1){
+                    auto const ix = word * Grid::word_bits + static_cast<std::size_t>(std::countr_zero(quads));
+
+                    // gather all corners on the grid of the batch, unoccupied ones are never referenced by the
+                    // triangulation
+                    std::array<raster_point, 4> const corners{{
+                        snap_to_subpixel(raster_image(ix, iy), bits),
+                        snap_to_subpixel(raster_image(ix + 1, iy), bits),
+                        snap_to_subpixel(raster_image(ix, iy + 1), bits),
+                        snap_to_subpixel(raster_image(ix + 1, iy + 1), bits)}};
+
+                    auto const occupancy = raster_image.occupancy(ix, iy);
+                    auto min_x = std::numeric_limits<double>::infinity();
+                    auto max_x = -min_x;
+                    auto min_y = min_x;
+                    auto max_y = max_x;
+                    for(std::size_t c = 0; c < 4; ++c){
+                        if((occupancy >> c) & 1){
+                            min_x = std::min(min_x, corners[c].x);
+                            max_x = std::max(max_x, corners[c].x);
+                            min_y = std::min(min_y, corners[c].y);
+                            max_y = std::max(max_y, corners[c].y);
+                        }
+                    }
+
+                    // pixel centres within the bounding box and the target image, NaN gives none
+                    auto const left = std::max(std::ceil(min_x), 0.);
+                    auto const right = std::min(std::floor(max_x), static_cast<double>(width - 1));
+                    auto const top = std::max(std::ceil(min_y), 0.);
+                    auto const bottom = std::min(std::floor(max_y), static_cast<double>(height - 1));
+                    if(!(left <= right && top <= bottom)){
+                        ++counts.empty;
+                        continue;
+                    }
+
+                    auto const& quad = triangulate_quad(occupancy, corners, tessellation);
+                    if(left == right && top == bottom){
+                        ++counts.single;
+                        for(auto const& corner_index: std::span(quad.triangles.data(), quad.count)){
+                            batch.push_single(
+                                {{corners[corner_index[0]], corners[corner_index[1]], corners[corner_index[2]]}},
+                                static_cast<std::size_t>(left), static_cast<std::size_t>(top), width, height);
+                        }
+                        continue;
+                    }
+
+                    ++counts.full;
+                    for(auto const& corner_index: std::span(quad.triangles.data(), quad.count)){
+                        batch.push({{corners[corner_index[0]], corners[corner_index[1]], corners[corner_index[2]]}},
+                            width, height);
+                    }
+                }
+            });
+
+        return counts;
+    }
+
+
+    /// \brief Raster row pairs of a raster_grid or a sparse_raster_grid
+    template <typename Grid>
+    class grid_rows{
+    public:
+        grid_rows(Grid const& raster_image, quad_tessellation const tessellation, raster_settings const& settings)
+            : raster_image_(raster_image)
+            , tessellation_(tessellation)
+            , settings_(settings) {}
+
+        Grid const& grid()const noexcept{
+            return raster_image_;
+        }
+
+        /// \brief Empty batch with the raster settings of the rows
+        triangle_batch make_batch()const noexcept{
+            return triangle_batch(settings_);
+        }
+
+        /// \brief Count of raster row pairs
+        std::size_t count()const noexcept{
+            return raster_image_.h() - 1;
+        }
+
+        /// \brief Set up the triangles of raster row pair iy
+        ///
+        /// May be called concurrently. The quads are not added to quad_paths(), the caller sums the returned counts
+        /// and adds them with add_quad_paths.
+        ///
+        /// \return the count of quads of the row per setup path
+        quad_path_counts setup_row(
+            std::size_t const iy,
+            std::size_t const width,
+            std::size_t const height,
+            triangle_batch& batch
+        )const{
+            return setup_raster_row(raster_image_, iy, width, height, tessellation_, batch);
+        }
+
+        /// \brief Set up the triangles of every raster row pair in order and pass them to f(batch)
+        template <typename F>
+        void for_each(std::size_t const width, std::size_t const height, F&& f)const{
+            auto batch = make_batch();
+            quad_path_counts counts;
+            for(std::size_t iy = 0; iy < count(); ++iy){
+                counts += setup_row(iy, width, height, batch);
+                f(std::as_const(batch));
+            }
+            add_quad_paths(counts);
+        }
+
+        /// \brief Add quads that were set up with setup_row to quad_paths()
+        void add_quad_paths(quad_path_counts const& counts)const noexcept{
+            quad_paths_ += counts;
+        }
+
+        /// \brief Quads per setup path over all raster passes of these rows
+        quad_path_counts const& quad_paths()const noexcept{
+            return quad_paths_;
+        }
+
+    private:
+        Grid const& raster_image_;
+        quad_tessellation tessellation_;
+        raster_settings settings_;
+        mutable quad_path_counts quad_paths_;
+    };
+
+    /// \brief True for row sources that keep the whole raster, their rows can be set up in any order
+    template <typename Rows>
+    inline constexpr bool is_grid_rows = false;
+
+    template <typename Grid>
+    inline constexpr bool is_grid_rows<grid_rows<Grid>> = true;
+
+
+    /// \brief Raster row pairs streamed from points sorted by raster y
+    ///
+    /// Only a window of two raster rows is resident. The row pair above a raster row is set up as soon as the first
+    /// point of a later row arrives. Missing raster rows give empty batches, so f is called for every row pair of
+    /// the range in the same order as with grid_rows.
+    class sliding_rows{
+    public:
+        /// \throw std::runtime_error if the points are not sorted by raster y
+        sliding_rows(
+            std::vector<raster_point> const& points,
+            raster_range const& range,
+            quad_tessellation const tessellation,
+            raster_settings const& settings
+        )
+            : points_(points)
+            , range_(range)
+            , tessellation_(tessellation)
+            , settings_(settings)
+        {
+            if(!std::ranges::is_sorted(points, {}, &raster_point::ry)){
+                throw std::runtime_error("the points are not sorted by raster y");
+            }
+        }
+
+        /// \brief Count of raster row pairs
+        std::size_t count()const noexcept{
+            return range_.h() - 1;
+        }
+
+        /// \brief Empty batch with the raster settings of the rows
+        triangle_batch make_batch()const noexcept{
+            return triangle_batch(settings_);
+        }
+
+        /// \brief Set up the triangles of every raster row pair in order and pass them to f(batch)
+        template <typename F>
+        void for_each(std::size_t const width, std::size_t const height, F&& f)const{
+            // row 0 is the previous raster row, row 1 the one that is currently filled
+            raster_grid window(raster_range{range_.min_x, range_.max_x, range_.min_y - 1, range_.min_y});
+            auto batch = make_batch();
+            quad_path_counts counts;
+
+            auto current = range_.min_y;
+            auto const finish_row = [&]{
+                    if(current > range_.min_y){
+                        counts += setup_raster_row(window, 0, width, height, tessellation_, batch);
+                        f(std::as_const(batch));
+                    }
+                };
+
+            for(auto const& p: points_){
+                for(; current < p.ry; ++current){
+                    finish_row();
+                    window.shift_rows();
+                }
+
+                window.insert(p);
+            }
+
+            finish_row();
+            quad_paths_ += counts;
+        }
+
+        /// \brief Quads per setup path over all raster passes of these rows
+        quad_path_counts const& quad_paths()const noexcept{
+            return quad_paths_;
+        }
+
+    private:
+        std::vector<raster_point> const& points_;
+        raster_range range_;
+        quad_tessellation tessellation_;
+        raster_settings settings_;
+        mutable quad_path_counts quad_paths_;
+    };
+
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "raster_index.hpp"
+#include "raster_point.hpp"
+
+#include <fmt/format.h>
+
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Additional values per raster point that are looked up by the raster id of the point
+    ///
+    /// The values of a point are stored consecutively, channel after channel.
+    class raster_values{
+    public:
+        /// \brief channels[c][i] is the value of channel c of points[i]
+        ///
+        /// \throw std::runtime_error if a raster id exists twice or a channel has not one value per point
+        raster_values(std::vector<raster_point> const& points, std::vector<std::vector<double>> const& channels)
+            : index_(points.size())
+            , channel_count_(channels.size())
+            , values_(points.size() * channels.size())
+        {
+            for(auto const& channel: channels){
+                if(channel.size() != points.size()){
+                    throw std::runtime_error("value channel has different value count then the points");
+                }
+            }
+
+            for(std::size_t i = 0; i < points.size(); ++i){
+                if(!index_.insert(points[i].rx, points[i].ry, i)){
+                    throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice",
+                        points[i].rx, points[i].ry));
+                }
+
+                for(std::size_t c = 0; c < channel_count_; ++c){
+                    values_[i * channel_count_ + c] = channels[c][i];
+                }
+            }
+        }
+
+        std::size_t channel_count()const noexcept{
+            return channel_count_;
+        }
+
+        /// \brief Values of the raster point (rx, ry)
+        ///
+        /// \throw std::out_of_range if there is no such raster point
+        std::span<double const> operator()(std::int64_t const rx, std::int64_t const ry)const{
+            auto const i = index_.find(rx, ry);
+            if(i == raster_index::npos){
+                throw std::out_of_range(fmt::format("no values for raster point {:d}x{:d}", rx, ry));
+            }
+            return std::span(values_).subspan(i * channel_count_, channel_count_);
+        }
+
+    private:
+        raster_index index_;
+        std::size_t channel_count_;
+        std::vector<double> values_;
+    };
+
+
+}
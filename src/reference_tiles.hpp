@@ -0,0 +1,343 @@
+#pragma once
+
+#include "raster_index.hpp"
+#include "raster_point.hpp"
+#include "triangle_rasterizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Raster filter reference fragment of a pixel
+    struct reference_pixel{
+        double value;
+        std::int64_t rx;
+        std::int64_t ry;
+        bool valid;
+    };
+
+
+    /// \brief Most relevant point value for the raster filter per block of 8 x 8 raster ids
+    ///
+    /// RasterFilter::replaces(candidate, reference) orders the values, RasterFilter::initial is replaced by every
+    /// value. A NaN value makes its block unbounded.
+    template <typename RasterFilter>
+    class raster_value_blocks{
+    public:
+        /// \brief Count of raster ids per block side
+        static constexpr std::int64_t block_size = 8;
+
+        explicit raster_value_blocks(std::vector<raster_point> const& points)
+            : index_(points.size() / (block_size * block_size))
+        {
+            for(auto const& p: points){
+                auto const bx = floor_div(p.rx, block_size);
+                auto const by = floor_div(p.ry, block_size);
+                if(index_.insert(bx, by, values_.size())){
+                    values_.push_back(RasterFilter::initial);
+                }
+
+                auto& value = values_[index_.find(bx, by)];
+                if(std::isnan(p.v)){
+                    value = -RasterFilter::initial;
+                }else if(RasterFilter::replaces(p.v, value)){
+                    value = p.v;
+                }
+            }
+        }
+
+        /// \brief Value that is at least as relevant as every interpolated value between points with raster ids in
+        ///        [min_rx, max_rx] x [min_ry, max_ry]
+        ///
+        /// The most relevant point value is widened by 2^-20 of its magnitude and the smallest normal float, this
+        /// covers the rounding of the interpolation and of the compact fragments.
+        double most_relevant(
+            std::int64_t const min_rx,
+            std::int64_t const max_rx,
+            std::int64_t const min_ry,
+            std::int64_t const max_ry
+        )const noexcept{
+            auto result = RasterFilter::initial;
+            for(auto by = floor_div(min_ry, block_size); by <= floor_div(max_ry, block_size); ++by){
+                for(auto bx = floor_div(min_rx, block_size); bx <= floor_div(max_rx, block_size); ++bx){
+                    if(auto const i = index_.find(bx, by); i != raster_index::npos &&
+                        !RasterFilter::replaces(result, values_[i])
+                    ){
+                        result = values_[i];
+                    }
+                }
+            }
+
+            if(std::isinf(result)){
+                return result;
+            }
+
+            auto const margin = std::abs(result) * 0x1p-20 + double(std::numeric_limits<float>::min());
+            return RasterFilter::replaces(result - margin, result) ? result - margin : result + margin;
+        }
+
+    private:
+        raster_index index_;
+        std::vector<double> values_;
+    };
+
+
+    /// \brief Conservative running bounds of the raster filter reference per image tile of 16 x 16 pixels
+    ///
+    /// A fragment passes the raster filter only if its raster id is within the ±1 neighbourhood of the reference
+    /// of its pixel. The raster id of a fragment is the one of a triangle vertex and the vertices of a triangle are
+    /// within ±1 of each other. So if a fragment of triangle T passes, the reference is interpolated between
+    /// points whose raster ids are within ±2 of the vertices of T, and the reference value is at most as relevant
+    /// as the most relevant of these point values.
+    ///
+    /// On the other hand, every fragment value that is added during the rasterization is at most as relevant as
+    /// the final reference of its pixel. Once every pixel of a tile received a fragment, the least relevant of the
+    /// running references bounds the final references of the tile from the other side. A triangle is rejected if
+    /// this bound is more relevant than the most relevant value around the triangle in every tile it overlaps, its
+    /// fragments can then neither be the reference nor pass the filter. This holds for any subset of the added
+    /// fragments, so the bounds may be updated concurrently and rejected triangles need not be added.
+    ///
+    /// The tile bound is recomputed when the last pixel is covered and again after every 64 improvements.
+    template <typename RasterFilter>
+    class reference_tiles{
+    public:
+        /// \brief Count of pixels per tile side
+        static constexpr std::size_t tile_size = 16;
+
+        reference_tiles(std::size_t const width, std::size_t const height, std::vector<raster_point> const& points)
+            : width_(width)
+            , height_(height)
+            , tiles_w_((width + tile_size - 1) / tile_size)
+            , values_(points)
+            , pixels_(width * height, RasterFilter::initial)
+            , tiles_(tiles_w_ * ((height + tile_size - 1) / tile_size))
+        {
+            for(std::size_t ty = 0; ty * tile_size < height; ++ty){
+                for(std::size_t tx = 0; tx * tile_size < width; ++tx){
+                    auto& t = tiles_[ty * tiles_w_ + tx];
+                    t.uncovered.store(static_cast<std::uint32_t>(
+                        (std::min(width, (tx + 1) * tile_size) - tx * tile_size) *
+                        (std::min(height, (ty + 1) * tile_size) - ty * tile_size)), std::memory_order_relaxed);
+                    t.bound.store(RasterFilter::initial, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// \brief Add a fragment value of pixel (x, y)
+        void add(std::size_t const x, std::size_t const y, double const value)noexcept{
+            auto& pixel = pixels_[y * width_ + x];
+            if(!RasterFilter::replaces(value, pixel)){
+                return;
+            }
+
+            auto const first = pixel == RasterFilter::initial;
+            pixel = value;
+
+            auto& t = tile(x, y);
+            if(first){
+                auto const uncovered = t.uncovered.load(std::memory_order_relaxed) - 1;
+                t.uncovered.store(uncovered, std::memory_order_relaxed);
+                if(uncovered == 0){
+                    update_bound(x, y);
+                }
+            }else if(t.uncovered.load(std::memory_order_relaxed) == 0){
+                auto const updates = t.updates.load(std::memory_order_relaxed) + 1;
+                t.updates.store(updates, std::memory_order_relaxed);
+                if(updates == refresh_updates){
+                    update_bound(x, y);
+                }
+            }
+        }
+
+        /// \brief Add a fragment value of pixel (x, y) in a pass that runs on several threads
+        void add_concurrent(std::size_t const x, std::size_t const y, double const value)noexcept{
+            std::atomic_ref pixel(pixels_[y * width_ + x]);
+            auto old = pixel.load(std::memory_order_relaxed);
+            do{
+                if(!RasterFilter::replaces(value, old)){
+                    return;
+                }
+            }while(!pixel.compare_exchange_weak(old, value, std::memory_order_relaxed));
+
+            auto& t = tile(x, y);
+            if(old == RasterFilter::initial){
+                if(t.uncovered.fetch_sub(1, std::memory_order_relaxed) == 1){
+                    update_bound(x, y);
+                }
+            }else if(t.uncovered.load(std::memory_order_relaxed) == 0 &&
+                t.updates.fetch_add(1, std::memory_order_relaxed) + 1 == refresh_updates
+            ){
+                update_bound(x, y);
+            }
+        }
+
+        /// \brief Recompute the bounds of all covered tiles, e.g. after a pass that found all references
+        void update_bounds()noexcept{
+            for(std::size_t ty = 0; ty * tile_size < height_; ++ty){
+                for(std::size_t tx = 0; tx * tile_size < width_; ++tx){
+                    if(tiles_[ty * tiles_w_ + tx].uncovered.load(std::memory_order_relaxed) == 0){
+                        update_bound(tx * tile_size, ty * tile_size);
+                    }
+                }
+            }
+        }
+
+        /// \brief False if no fragment of triangle i of batch can pass the raster filter
+        bool may_accept(triangle_batch const& batch, std::size_t const i)const noexcept{
+            auto const rx = batch.raster_x(i);
+            auto const ry = batch.raster_y(i);
+            auto const [min_rx, max_rx] = std::ranges::minmax(rx);
+            auto const [min_ry, max_ry] = std::ranges::minmax(ry);
+            auto const limit = values_.most_relevant(min_rx - 2, max_rx + 2, min_ry - 2, max_ry + 2);
+
+            auto const box = batch.box(i);
+            for(auto ty = box.fy / tile_size; ty <= box.ty / tile_size; ++ty){
+                for(auto tx = box.fx / tile_size; tx <= box.tx / tile_size; ++tx){
+                    auto const bound = tiles_[ty * tiles_w_ + tx].bound.load(std::memory_order_relaxed);
+                    if(!RasterFilter::replaces(bound, limit)){
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        /// \brief Count total triangles of which culled were rejected, may be called concurrently
+        void count_triangles(std::size_t const total, std::size_t const culled)noexcept{
+            total_.fetch_add(total, std::memory_order_relaxed);
+            culled_.fetch_add(culled, std::memory_order_relaxed);
+        }
+
+        /// \brief Count of tested triangles
+        std::size_t total()const noexcept{
+            return total_.load(std::memory_order_relaxed);
+        }
+
+        /// \brief Count of rejected triangles
+        std::size_t culled()const noexcept{
+            return culled_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        /// \brief Improvements of the running references of a covered tile after which its bound is recomputed
+        static constexpr std::uint32_t refresh_updates = 64;
+
+        struct tile_state{
+            /// \brief Count of pixels without fragment
+            std::atomic<std::uint32_t> uncovered{0};
+
+            /// \brief Improvements since the bound was computed
+            std::atomic<std::uint32_t> updates{0};
+
+            /// \brief Least relevant running reference of the tile, RasterFilter::initial while uncovered
+            std::atomic<double> bound{0.};
+        };
+
+        tile_state& tile(std::size_t const x, std::size_t const y)noexcept{
+            return tiles_[(y / tile_size) * tiles_w_ + x / tile_size];
+        }
+
+        /// \brief Set the bound of the covered tile of pixel (x, y) to its least relevant running reference
+        void update_bound(std::size_t const x, std::size_t const y)noexcept{
+            auto const fx = x / tile_size * tile_size;
+            auto const fy = y / tile_size * tile_size;
+            auto bound = -RasterFilter::initial;
+            for(auto py = fy; py < std::min(height_, fy + tile_size); ++py){
+                for(auto px = fx; px < std::min(width_, fx + tile_size); ++px){
+                    auto const value = std::atomic_ref(pixels_[py * width_ + px]).load(std::memory_order_relaxed);
+                    if(RasterFilter::replaces(bound, value)){
+                        bound = value;
+                    }
+                }
+            }
+
+            auto& t = tile(x, y);
+            t.updates.store(0, std::memory_order_relaxed);
+            t.bound.store(bound, std::memory_order_relaxed);
+        }
+
+        std::size_t width_;
+        std::size_t height_;
+        std::size_t tiles_w_;
+        raster_value_blocks<RasterFilter> values_;
+        std::vector<double> pixels_;
+        std::vector<tile_state> tiles_;
+        std::atomic<std::size_t> total_{0};
+        std::atomic<std::size_t> culled_{0};
+    };
+
+
+    /// \brief Reference tiles of two raster filters that are resolved from the same fragments, a triangle is
+    ///        rejected only if it can pass neither filter
+    ///
+    /// The triangle counts are kept by the tiles of the first filter.
+    template <typename FirstFilter, typename SecondFilter>
+    class reference_tiles_pair{
+    public:
+        reference_tiles_pair(std::size_t const width, std::size_t const height, std::vector<raster_point> const& points)
+            : first_(width, height, points)
+            , second_(width, height, points) {}
+
+        void add(std::size_t const x, std::size_t const y, double const value)noexcept{
+            first_.add(x, y, value);
+            second_.add(x, y, value);
+        }
+
+        void add_concurrent(std::size_t const x, std::size_t const y, double const value)noexcept{
+            first_.add_concurrent(x, y, value);
+            second_.add_concurrent(x, y, value);
+        }
+
+        void update_bounds()noexcept{
+            first_.update_bounds();
+            second_.update_bounds();
+        }
+
+        bool may_accept(triangle_batch const& batch, std::size_t const i)const noexcept{
+            return first_.may_accept(batch, i) || second_.may_accept(batch, i);
+        }
+
+        void count_triangles(std::size_t const total, std::size_t const culled)noexcept{
+            first_.count_triangles(total, culled);
+        }
+
+        std::size_t total()const noexcept{
+            return first_.total();
+        }
+
+        std::size_t culled()const noexcept{
+            return first_.culled();
+        }
+
+    private:
+        reference_tiles<FirstFilter> first_;
+        reference_tiles<SecondFilter> second_;
+    };
+
+
+    /// \brief Stand-in for reference_tiles without raster filter, it accepts every triangle
+    struct no_reference_tiles{
+        void add(std::size_t, std::size_t, double)noexcept{}
+
+        void add_concurrent(std::size_t, std::size_t, double)noexcept{}
+
+        void update_bounds()noexcept{}
+
+        bool may_accept(triangle_batch const&, std::size_t)const noexcept{
+            return true;
+        }
+
+        void count_triangles(std::size_t, std::size_t)noexcept{}
+    };
+
+
+}
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PLY2IMAGE_X86_SPAN_KERNELS
+#include <immintrin.h>
+#endif
+
+
+namespace ply2image{
+
+
+    /// \brief Instruction set of the span kernel
+    enum class simd_level{
+        automatic = 0,
+        scalar = 1,
+        sse4_2 = 2,
+        avx2 = 3,
+        avx512 = 4
+    };
+
+
+    /// \brief Pixels per block of the incremental edge function stepping, equal to the widest lane group
+    constexpr std::size_t span_block = 8;
+
+    /// \brief Edge function value at pixel k of a span with value e at the first pixel and step a per pixel
+    ///
+    /// The pixels of the first block are evaluated directly. Every later pixel steps the value of the pixel one
+    /// block before by span_block * a. All kernels use this order of operations, only their lane groups differ,
+    /// so they give bitwise identical results.
+    constexpr double span_edge(double const e, double const a, std::size_t const k)noexcept{
+        auto value = e + a * static_cast<double>(k % span_block);
+        auto const step = a * static_cast<double>(span_block);
+        for(auto block = k / span_block; block > 0; --block){
+            value += step;
+        }
+        return value;
+    }
+
+
+    /// \brief Edge functions and vertex values of a triangle along one row of its bounding box
+    struct span_setup{
+        /// \brief Edge function values at the first pixel
+        std::array<double, 3> e;
+
+        /// \brief Edge function steps per pixel
+        std::array<double, 3> a;
+
+        std::array<double, 3> v;
+        double rcp_area2;
+
+        /// \brief Count of pixels in the row
+        std::size_t n;
+    };
+
+    /// \brief The inside pixels [first, first + count) of a span relative to its first pixel
+    struct span_range{
+        std::size_t first;
+        std::size_t count;
+    };
+
+    /// \brief Per pixel results of the span kernel indexed by the pixel offset in the span
+    struct span_fragments{
+        /// \brief Maximum count of lanes of any kernel, the kernels store whole lane groups
+        static constexpr std::size_t max_lanes = span_block;
+
+        /// \brief Weight of the dominant vertex
+        std::vector<double> weight;
+
+        /// \brief Interpolated value
+        std::vector<double> value;
+
+        /// \brief Index of the dominant vertex
+        std::vector<std::uint8_t> index;
+
+        /// \brief Make room for a span of n pixels
+        void fit(std::size_t const n){
+            if(weight.size() < n + max_lanes){
+                weight.resize(n + max_lanes);
+                value.resize(n + max_lanes);
+                index.resize(n + max_lanes);
+            }
+        }
+    };
+
+
+    /// \brief Tracks the contiguous inside run of a span over lane groups
+    ///
+    /// The inside of a triangle row is contiguous, so the run ends at the first outside pixel after an inside one.
+    /// Later inside pixels caused by rounding are ignored like in the scalar kernel.
+    struct span_tracker{
+        span_range range{0, 0};
+        bool entered = false;
+
+        /// \brief Add the inside mask of the lane group that starts at pixel k
+        ///
+        /// \return true if the run ended within the group
+        bool add(std::uint32_t mask, std::size_t lanes, std::size_t const k)noexcept{
+            if(!entered){
+                if(mask == 0){
+                    return false;
+                }
+
+                auto const skip = static_cast<std::size_t>(std::countr_zero(mask));
+                entered = true;
+                range.first = k + skip;
+                mask >>= skip;
+                lanes -= skip;
+            }
+
+            auto const run = static_cast<std::size_t>(std::countr_one(mask));
+            range.count += run;
+            return run < lanes;
+        }
+    };
+
+    /// \brief Bits of the lanes that lie within the remaining pixels of a span
+    constexpr std::uint32_t valid_lanes(std::size_t const remaining, std::size_t const lanes)noexcept{
+        return remaining >= lanes
+            ? (std::uint32_t(1) << lanes) - 1
+            : (std::uint32_t(1) << remaining) - 1;
+    }
+
+
+    /// \brief Weight of the dominant vertex, interpolated value and index of the dominant vertex at one pixel
+    struct span_pixel{
+        double weight;
+        double value;
+        std::uint8_t index;
+    };
+
+    /// \brief Interpolate at a pixel inside a triangle from its edge function values e
+    ///
+    /// On equal weights the later vertex is dominant.
+    constexpr span_pixel interpolate_pixel(
+        std::array<double, 3> const& e,
+        double const rcp_area2,
+        std::array<double, 3> const& v
+    )noexcept{
+        std::array<double, 3> const weight{{e[0] * rcp_area2, e[1] * rcp_area2, e[2] * rcp_area2}};
+
+        std::uint8_t index = weight[1] >= weight[0] ? 1 : 0;
+        if(weight[2] >= weight[index]){
+            index = 2;
+        }
+
+        return {weight[index], v[0] * weight[0] + v[1] * weight[1] + v[2] * weight[2], index};
+    }
+
+
+    /// \brief Test and interpolate pixel by pixel
+    ///
+    /// This is the reference for all vectorized kernels, they give bitwise identical results. The edge values of
+    /// the last block are kept per pixel of the block and stepped as in span_edge.
+    template <bool Interpolate>
+    span_range span_scalar(span_setup const& s, span_fragments* const out)noexcept{
+        std::array<std::array<double, span_block>, 3> block;
+        std::array<double, 3> const step{{
+            s.a[0] * static_cast<double>(span_block),
+            s.a[1] * static_cast<double>(span_block),
+            s.a[2] * static_cast<double>(span_block)}};
+
+        span_tracker span;
+        for(std::size_t k = 0; k < s.n; ++k){
+            auto const l = k % span_block;
+            for(std::size_t j = 0; j < 3; ++j){
+                block[j][l] = k < span_block ? s.e[j] + s.a[j] * static_cast<double>(k) : block[j][l] + step[j];
+            }
+            std::array<double, 3> const e{{block[0][l], block[1][l], block[2][l]}};
+
+            auto const inside = e[0] >= 0. && e[1] >= 0. && e[2] >= 0.;
+            if(inside && Interpolate){
+                auto const pixel = interpolate_pixel(e, s.rcp_area2, s.v);
+                out->weight[k] = pixel.weight;
+                out->value[k] = pixel.value;
+                out->index[k] = pixel.index;
+            }
+
+            if(span.add(inside ? 1 : 0, 1, k)){
+                break;
+            }
+        }
+        return span.range;
+    }
+
+
+    /// \brief Integer edge functions and vertex values of a triangle along one row on the fixed-point grid
+    struct fixed_span_setup{
+        /// \brief Edge function values at the first pixel
+        std::array<std::int64_t, 3> e;
+
+        /// \brief Edge function steps per pixel
+        std::array<std::int64_t, 3> a;
+
+        /// \brief A pixel is inside if e >= bias for all edges, 0 for top and left edges and 1 for all others
+        std::array<std::int64_t, 3> bias;
+
+        std::array<double, 3> v;
+        double rcp_area2;
+
+        /// \brief Count of pixels in the row
+        std::size_t n;
+    };
+
+    /// \brief Smallest integer >= n / d for d > 0
+    constexpr std::int64_t ceil_div(std::int64_t const n, std::int64_t const d)noexcept{
+        return n >= 0 ? (n + d - 1) / d : -(-n / d);
+    }
+
+    /// \brief Largest integer <= n / d for d > 0
+    constexpr std::int64_t floor_div(std::int64_t const n, std::int64_t const d)noexcept{
+        return n >= 0 ? n / d : -((-n + d - 1) / d);
+    }
+
+    /// \brief Find the inside pixels of a fixed-point span by integer division and interpolate only those
+    ///
+    /// The inside pixels of every edge form a half line of the span. Its end is computed exactly, so the test
+    /// needs no per pixel work and the interpolation runs only over the inside pixels.
+    template <bool Interpolate>
+    span_range span_fixed(fixed_span_setup const& s, span_fragments* const out)noexcept{
+        std::int64_t first = 0;
+        auto last = static_cast<std::int64_t>(s.n);
+        for(std::size_t k = 0; k < 3; ++k){
+            if(s.a[k] > 0){
+                first = std::max(first, ceil_div(s.bias[k] - s.e[k], s.a[k]));
+            }else if(s.a[k] < 0){
+                last = std::min(last, floor_div(s.e[k] - s.bias[k], -s.a[k]) + 1);
+            }else if(s.e[k] < s.bias[k]){
+                return {0, 0};
+            }
+        }
+
+        if(first >= last){
+            return {0, 0};
+        }
+
+        if constexpr(Interpolate){
+            for(auto k = first; k < last; ++k){
+                std::array<double, 3> const e{{
+                    static_cast<double>(s.e[0] + s.a[0] * k),
+                    static_cast<double>(s.e[1] + s.a[1] * k),
+                    static_cast<double>(s.e[2] + s.a[2] * k)}};
+
+                auto const pixel = interpolate_pixel(e, s.rcp_area2, s.v);
+                auto const i = static_cast<std::size_t>(k);
+                out->weight[i] = pixel.weight;
+                out->value[i] = pixel.value;
+                out->index[i] = pixel.index;
+            }
+        }
+
+        return {static_cast<std::size_t>(first), static_cast<std::size_t>(last - first)};
+    }
+
+
+#ifdef PLY2IMAGE_X86_SPAN_KERNELS
+    /// \brief Store the dominant vertex indices of a lane group from the masks of the two comparisons
+    inline void store_span_index(
+        std::uint8_t* const index,
+        std::uint32_t const second,
+        std::uint32_t const third,
+        std::size_t const lanes
+    )noexcept{
+        for(std::size_t l = 0; l < lanes; ++l){
+            index[l] = static_cast<std::uint8_t>((third >> l) & 1 ? 2 : (second >> l) & 1);
+        }
+    }
+
+    /// \brief Test and interpolate 2 pixels per step
+    ///
+    /// The edge values of the 4 lane groups of the last block are stepped as in span_edge.
+    template <bool Interpolate>
+    [[gnu::target("sse4.2")]] span_range span_sse4_2(span_setup const& s, span_fragments* const out)noexcept{
+        constexpr std::size_t lanes = 2;
+        constexpr std::size_t groups = span_block / lanes;
+        auto const lane = _mm_set_pd(1., 0.);
+        auto const zero = _mm_setzero_pd();
+
+        __m128d block[3][groups];
+        __m128d step[3];
+        for(std::size_t j = 0; j < 3; ++j){
+            step[j] = _mm_set1_pd(s.a[j] * static_cast<double>(span_block));
+        }
+
+        span_tracker span;
+        for(std::size_t k = 0; k < s.n; k += lanes){
+            auto const g = k / lanes % groups;
+            __m128d e[3];
+            for(std::size_t j = 0; j < 3; ++j){
+                block[j][g] = k < span_block
+                    ? _mm_add_pd(_mm_set1_pd(s.e[j]), _mm_mul_pd(_mm_set1_pd(s.a[j]),
+                        _mm_add_pd(_mm_set1_pd(static_cast<double>(k)), lane)))
+                    : _mm_add_pd(block[j][g], step[j]);
+                e[j] = block[j][g];
+            }
+
+            auto const inside = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(e[0], zero), _mm_cmpge_pd(e[1], zero)),
+                _mm_cmpge_pd(e[2], zero));
+            auto const mask = static_cast<std::uint32_t>(_mm_movemask_pd(inside)) & valid_lanes(s.n - k, lanes);
+
+            if(Interpolate && mask != 0){
+                auto const rcp_area2 = _mm_set1_pd(s.rcp_area2);
+                __m128d w[3];
+                for(std::size_t j = 0; j < 3; ++j){
+                    w[j] = _mm_mul_pd(e[j], rcp_area2);
+                }
+
+                auto const second = _mm_cmpge_pd(w[1], w[0]);
+                auto const w01 = _mm_blendv_pd(w[0], w[1], second);
+                auto const third = _mm_cmpge_pd(w[2], w01);
+
+                _mm_storeu_pd(out->weight.data() + k, _mm_blendv_pd(w01, w[2], third));
+                _mm_storeu_pd(out->value.data() + k, _mm_add_pd(_mm_add_pd(
+                    _mm_mul_pd(_mm_set1_pd(s.v[0]), w[0]), _mm_mul_pd(_mm_set1_pd(s.v[1]), w[1])),
+                    _mm_mul_pd(_mm_set1_pd(s.v[2]), w[2])));
+                store_span_index(out->index.data() + k, static_cast<std::uint32_t>(_mm_movemask_pd(second)),
+                    static_cast<std::uint32_t>(_mm_movemask_pd(third)), lanes);
+            }
+
+            if(span.add(mask, lanes, k)){
+                break;
+            }
+        }
+        return span.range;
+    }
+
+    /// \brief Test and interpolate 4 pixels per step
+    ///
+    /// The edge values of the 2 lane groups of the last block are stepped as in span_edge.
+    template <bool Interpolate>
+    [[gnu::target("avx2")]] span_range span_avx2(span_setup const& s, span_fragments* const out)noexcept{
+        constexpr std::size_t lanes = 4;
+        constexpr std::size_t groups = span_block / lanes;
+        auto const lane = _mm256_set_pd(3., 2., 1., 0.);
+        auto const zero = _mm256_setzero_pd();
+
+        __m256d block[3][groups];
+        __m256d step[3];
+        for(std::size_t j = 0; j < 3; ++j){
+            step[j] = _mm256_set1_pd(s.a[j] * static_cast<double>(span_block));
+        }
+
+        span_tracker span;
+        for(std::size_t k = 0; k < s.n; k += lanes){
+            auto const g = k / lanes % groups;
+            __m256d e[3];
+            for(std::size_t j = 0; j < 3; ++j){
+                block[j][g] = k < span_block
+                    ? _mm256_add_pd(_mm256_set1_pd(s.e[j]), _mm256_mul_pd(_mm256_set1_pd(s.a[j]),
+                        _mm256_add_pd(_mm256_set1_pd(static_cast<double>(k)), lane)))
+                    : _mm256_add_pd(block[j][g], step[j]);
+                e[j] = block[j][g];
+            }
+
+            auto const inside = _mm256_and_pd(_mm256_and_pd(
+                _mm256_cmp_pd(e[0], zero, _CMP_GE_OQ), _mm256_cmp_pd(e[1], zero, _CMP_GE_OQ)),
+                _mm256_cmp_pd(e[2], zero, _CMP_GE_OQ));
+            auto const mask = static_cast<std::uint32_t>(_mm256_movemask_pd(inside)) & valid_lanes(s.n - k, lanes);
+
+            if(Interpolate && mask != 0){
+                auto const rcp_area2 = _mm256_set1_pd(s.rcp_area2);
+                __m256d w[3];
+                for(std::size_t j = 0; j < 3; ++j){
+                    w[j] = _mm256_mul_pd(e[j], rcp_area2);
+                }
+
+                auto const second = _mm256_cmp_pd(w[1], w[0], _CMP_GE_OQ);
+                auto const w01 = _mm256_blendv_pd(w[0], w[1], second);
+                auto const third = _mm256_cmp_pd(w[2], w01, _CMP_GE_OQ);
+
+                _mm256_storeu_pd(out->weight.data() + k, _mm256_blendv_pd(w01, w[2], third));
+                _mm256_storeu_pd(out->value.data() + k, _mm256_add_pd(_mm256_add_pd(
+                    _mm256_mul_pd(_mm256_set1_pd(s.v[0]), w[0]), _mm256_mul_pd(_mm256_set1_pd(s.v[1]), w[1])),
+                    _mm256_mul_pd(_mm256_set1_pd(s.v[2]), w[2])));
+                store_span_index(out->index.data() + k, static_cast<std::uint32_t>(_mm256_movemask_pd(second)),
+                    static_cast<std::uint32_t>(_mm256_movemask_pd(third)), lanes);
+            }
+
+            if(span.add(mask, lanes, k)){
+                break;
+            }
+        }
+        return span.range;
+    }
+
+    /// \brief Test and interpolate 8 pixels per step
+    ///
+    /// One lane group is one block, its edge values are stepped as in span_edge.
+    template <bool Interpolate>
+    [[gnu::target("avx512f")]] span_range span_avx512(span_setup const& s, span_fragments* const out)noexcept{
+        constexpr std::size_t lanes = span_block;
+        auto const lane = _mm512_set_pd(7., 6., 5., 4., 3., 2., 1., 0.);
+        auto const zero = _mm512_setzero_pd();
+
+        __m512d e[3];
+        __m512d step[3];
+        for(std::size_t j = 0; j < 3; ++j){
+            e[j] = _mm512_add_pd(_mm512_set1_pd(s.e[j]), _mm512_mul_pd(_mm512_set1_pd(s.a[j]), lane));
+            step[j] = _mm512_set1_pd(s.a[j] * static_cast<double>(span_block));
+        }
+
+        span_tracker span;
+        for(std::size_t k = 0; k < s.n; k += lanes){
+            if(k > 0){
+                for(std::size_t j = 0; j < 3; ++j){
+                    e[j] = _mm512_add_pd(e[j], step[j]);
+                }
+            }
+
+            auto const inside = static_cast<std::uint32_t>(
+                _mm512_cmp_pd_mask(e[0], zero, _CMP_GE_OQ) &
+                _mm512_cmp_pd_mask(e[1], zero, _CMP_GE_OQ) &
+                _mm512_cmp_pd_mask(e[2], zero, _CMP_GE_OQ));
+            auto const mask = inside & valid_lanes(s.n - k, lanes);
+
+            if(Interpolate && mask != 0){
+                auto const rcp_area2 = _mm512_set1_pd(s.rcp_area2);
+                __m512d w[3];
+                for(std::size_t j = 0; j < 3; ++j){
+                    w[j] = _mm512_mul_pd(e[j], rcp_area2);
+                }
+
+                auto const second = _mm512_cmp_pd_mask(w[1], w[0], _CMP_GE_OQ);
+                auto const w01 = _mm512_mask_blend_pd(second, w[0], w[1]);
+                auto const third = _mm512_cmp_pd_mask(w[2], w01, _CMP_GE_OQ);
+
+                _mm512_storeu_pd(out->weight.data() + k, _mm512_mask_blend_pd(third, w01, w[2]));
+                _mm512_storeu_pd(out->value.data() + k, _mm512_add_pd(_mm512_add_pd(
+                    _mm512_mul_pd(_mm512_set1_pd(s.v[0]), w[0]), _mm512_mul_pd(_mm512_set1_pd(s.v[1]), w[1])),
+                    _mm512_mul_pd(_mm512_set1_pd(s.v[2]), w[2])));
+                store_span_index(out->index.data() + k, second, third, lanes);
+            }
+
+            if(span.add(mask, lanes, k)){
+                break;
+            }
+        }
+        return span.range;
+    }
+#endif
+
+
+    /// \brief True if the CPU supports the instruction set
+    inline bool simd_level_supported(simd_level const level)noexcept{
+        switch(level){
+            case simd_level::automatic:
+            case simd_level::scalar:
+                return true;
+#ifdef PLY2IMAGE_X86_SPAN_KERNELS
+            case simd_level::sse4_2:
+                return __builtin_cpu_supports("sse4.2");
+            case simd_level::avx2:
+                return __builtin_cpu_supports("avx2");
+            case simd_level::avx512:
+                return __builtin_cpu_supports("avx512f");
+#else
+            default:
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    /// \brief Span kernel functions of one instruction set
+    struct span_kernel{
+        simd_level level;
+
+        /// \brief Find the inside pixels only
+        span_range (*cover)(span_setup const&, span_fragments*)noexcept;
+
+        /// \brief Find the inside pixels and store weight, value and dominant vertex of each in the fragments
+        span_range (*rasterize)(span_setup const&, span_fragments*)noexcept;
+    };
+
+    /// \brief Kernel of the instruction set, automatic picks the widest one the CPU supports
+    ///
+    /// \throw std::runtime_error if the CPU does not support the instruction set
+    inline span_kernel make_span_kernel(simd_level level){
+        if(level == simd_level::automatic){
+            level = simd_level::scalar;
+            for(auto const candidate: {simd_level::sse4_2, simd_level::avx2, simd_level::avx512}){
+                if(simd_level_supported(candidate)){
+                    level = candidate;
+                }
+            }
+        }
+
+        if(!simd_level_supported(level)){
+            throw std::runtime_error("the CPU does not support the requested SIMD instruction set");
+        }
+
+        switch(level){
+#ifdef PLY2IMAGE_X86_SPAN_KERNELS
+            case simd_level::sse4_2:
+                return {level, &span_sse4_2<false>, &span_sse4_2<true>};
+            case simd_level::avx2:
+                return {level, &span_avx2<false>, &span_avx2<true>};
+            case simd_level::avx512:
+                return {level, &span_avx512<false>, &span_avx512<true>};
+#endif
+            default:
+                return {simd_level::scalar, &span_scalar<false>, &span_scalar<true>};
+        }
+    }
+
+
+}
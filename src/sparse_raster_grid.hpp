@@ -0,0 +1,212 @@
+#pragma once
+
+#include "raster_grid.hpp"
+#include "raster_index.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Raster ranges with less cells are always stored densely
+    inline constexpr double sparse_raster_min_cells = 1 << 20;
+
+    /// \brief Fill density of the raster range below which the sparse raster grid is used
+    inline constexpr double sparse_raster_density = 0.125;
+
+    /// \brief True if point_count points fill the raster range too sparsely for a dense raster_grid
+    inline bool prefer_sparse_raster(std::size_t const point_count, raster_range const& range)noexcept{
+        auto const cells = static_cast<double>(range.w()) * static_cast<double>(range.h());
+        return cells > sparse_raster_min_cells && static_cast<double>(point_count) < sparse_raster_density * cells;
+    }
+
+
+    /// \brief Tiled raster of points for huge or sparsely filled raster ranges
+    ///
+    /// Only tiles of 64 x 16 cells that contain points are allocated, they are found by their tile position in a
+    /// raster_index. Every tile stores its cells in the same structure of arrays layout as raster_grid with one
+    /// mask word per tile row, so a mask word and a quad lookup cost one hash lookup. The interface matches
+    /// raster_grid.
+    class sparse_raster_grid{
+    public:
+        /// \brief Count of cells per mask word, this is the tile width
+        static constexpr std::size_t word_bits = raster_grid::word_bits;
+
+        /// \brief Count of rows per tile
+        static constexpr std::size_t tile_rows = 16;
+
+        /// \brief Count of cells per tile
+        static constexpr std::size_t tile_cells = word_bits * tile_rows;
+
+        sparse_raster_grid(raster_range const& range)
+            : range_(range)
+            , w_(range.w())
+            , h_(range.h()) {}
+
+        std::size_t w()const noexcept{
+            return w_;
+        }
+
+        std::size_t h()const noexcept{
+            return h_;
+        }
+
+        raster_range const& range()const noexcept{
+            return range_;
+        }
+
+        /// \brief Count of allocated tiles
+        std::size_t tile_count()const noexcept{
+            return tiles_.size();
+        }
+
+        /// \brief Insert a point at its raster position
+        ///
+        /// \throw std::runtime_error if the cell is already occupied
+        void insert(raster_point const& p){
+            auto const ix = range_.x(p.rx);
+            auto const iy = range_.y(p.ry);
+            auto const tile = make_tile(ix / word_bits, iy / tile_rows);
+            auto& word = valid_[tile * tile_rows + iy % tile_rows];
+            auto const bit = std::uint64_t(1) << (ix % word_bits);
+            if(word & bit){
+                throw std::runtime_error(fmt::format("raster point {:d}x{:d} exists twice", p.rx, p.ry));
+            }
+            word |= bit;
+
+            auto const i = tile * tile_cells + (iy % tile_rows) * word_bits + ix % word_bits;
+            x_[i] = p.x;
+            y_[i] = p.y;
+            v_[i] = p.v;
+        }
+
+        bool contains(std::size_t const ix, std::size_t const iy)const noexcept{
+            return (mask(ix / word_bits, iy) >> (ix % word_bits)) & 1;
+        }
+
+        /// \brief 4 bit occupancy mask of the quad with its upper left corner in cell (ix, iy)
+        ///
+        /// Bit 0 is (ix, iy), bit 1 is (ix + 1, iy), bit 2 is (ix, iy + 1) and bit 3 is (ix + 1, iy + 1).
+        std::uint8_t occupancy(std::size_t const ix, std::size_t const iy)const noexcept{
+            return static_cast<std::uint8_t>(
+                (contains(ix, iy) ? 0x1 : 0x0) |
+                (contains(ix + 1, iy) ? 0x2 : 0x0) |
+                (contains(ix, iy + 1) ? 0x4 : 0x0) |
+                (contains(ix + 1, iy + 1) ? 0x8 : 0x0));
+        }
+
+        /// \brief Assemble the point of an occupied cell, cells of missing tiles give zero values
+        raster_point operator()(std::size_t const ix, std::size_t const iy)const noexcept{
+            auto const rx = range_.min_x + static_cast<std::int64_t>(ix);
+            auto const ry = range_.min_y + static_cast<std::int64_t>(iy);
+            auto const tile = tiles_.find(static_cast<std::int64_t>(ix / word_bits),
+                static_cast<std::int64_t>(iy / tile_rows));
+            if(tile == raster_index::npos){
+                return {0., 0., 0., rx, ry};
+            }
+
+            auto const i = tile * tile_cells + (iy % tile_rows) * word_bits + ix % word_bits;
+            return {x_[i], y_[i], v_[i], rx, ry};
+        }
+
+        /// \brief Validity bits of the cells word * 64 to word * 64 + 63 in row iy, 0 for missing tiles
+        std::uint64_t mask(std::size_t const word, std::size_t const iy)const noexcept{
+            auto const tile = tiles_.find(static_cast<std::int64_t>(word), static_cast<std::int64_t>(iy / tile_rows));
+            return tile == raster_index::npos ? 0 : valid_[tile * tile_rows + iy % tile_rows];
+        }
+
+        /// \brief Bitmask of the quads with at least 3 occupied corners
+        ///
+        /// Bit i stands for the quad with its upper left corner in cell (word * 64 + i, iy).
+        std::uint64_t quad_mask(std::size_t const word, std::size_t const iy)const noexcept{
+            auto const top = mask(word, iy);
+            auto const bottom = mask(word, iy + 1);
+            if((top | bottom) == 0){
+                return 0;
+            }
+
+            return quad_bits(top, bottom, mask(word + 1, iy), mask(word + 1, iy + 1));
+        }
+
+        /// \brief Call f(word, quads) for every word of row iy with a nonzero quad_mask in ascending order
+        ///
+        /// Only the words of allocated tiles in the tile rows of row iy and iy + 1 are visited.
+        template <typename F>
+        void for_each_quad_word(std::size_t const iy, F&& f)const{
+            auto const& top = tile_columns(iy / tile_rows);
+            auto const& bottom = tile_columns((iy + 1) / tile_rows);
+
+            auto t = top.begin();
+            auto b = bottom.begin();
+            while(t != top.end() || b != bottom.end()){
+                std::size_t word;
+                if(b == bottom.end() || (t != top.end() && *t < *b)){
+                    word = *t++;
+                }else if(t == top.end() || *b < *t){
+                    word = *b++;
+                }else{
+                    word = *t++;
+                    ++b;
+                }
+
+                if(auto const quads = quad_mask(word, iy); quads != 0){
+                    f(word, quads);
+                }
+            }
+        }
+
+    private:
+        /// \brief Index of the tile at tile position (tx, ty), the tile is allocated if it does not exist
+        std::size_t make_tile(std::size_t const tx, std::size_t const ty){
+            if(auto const tile = tiles_.find(static_cast<std::int64_t>(tx), static_cast<std::int64_t>(ty));
+                tile != raster_index::npos
+            ){
+                return tile;
+            }
+
+            auto const tile = tiles_.size();
+            tiles_.insert(static_cast<std::int64_t>(tx), static_cast<std::int64_t>(ty), tile);
+
+            x_.resize(x_.size() + tile_cells);
+            y_.resize(y_.size() + tile_cells);
+            v_.resize(v_.size() + tile_cells);
+            valid_.resize(valid_.size() + tile_rows);
+
+            auto const row = rows_.size();
+            if(!rows_.insert(0, static_cast<std::int64_t>(ty), row)){
+                auto& columns = columns_[rows_.find(0, static_cast<std::int64_t>(ty))];
+                columns.insert(std::ranges::upper_bound(columns, tx), tx);
+            }else{
+                columns_.push_back({tx});
+            }
+
+            return tile;
+        }
+
+        /// \brief Sorted tile columns of the allocated tiles in tile row ty
+        std::vector<std::size_t> const& tile_columns(std::size_t const ty)const noexcept{
+            static std::vector<std::size_t> const empty;
+            auto const row = rows_.find(0, static_cast<std::int64_t>(ty));
+            return row == raster_index::npos ? empty : columns_[row];
+        }
+
+        raster_range range_;
+        std::size_t w_;
+        std::size_t h_;
+        raster_index tiles_;
+        raster_index rows_;
+        std::vector<std::vector<std::size_t>> columns_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        std::vector<double> v_;
+        std::vector<std::uint64_t> valid_;
+    };
+
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Bins of point indices per output tile that spill to disk
+    ///
+    /// Indices are appended to the bins in memory. As soon as all bins together hold more than memory_limit
+    /// indices, every bin is appended to its own file in a temporary directory and cleared. read() returns the
+    /// indices of a bin in the order they were added. The directory is removed by the destructor.
+    class tile_bins{
+    public:
+        tile_bins(std::size_t const tile_count, std::size_t const memory_limit)
+            : bins_(tile_count)
+            , spilled_(tile_count)
+            , memory_limit_(memory_limit) {}
+
+        tile_bins(tile_bins const&) = delete;
+        tile_bins& operator=(tile_bins const&) = delete;
+
+        ~tile_bins(){
+            if(!directory_.empty()){
+                std::error_code ignore;
+                std::filesystem::remove_all(directory_, ignore);
+            }
+        }
+
+        std::size_t size()const noexcept{
+            return bins_.size();
+        }
+
+        /// \brief Total count of indices added to bin tile
+        std::size_t count(std::size_t const tile)const noexcept{
+            return spilled_[tile] + bins_[tile].size();
+        }
+
+        /// \brief Count of times the bins were written to disk
+        std::size_t spill_count()const noexcept{
+            return spill_count_;
+        }
+
+        /// \brief Append a point index to bin tile
+        void push(std::size_t const tile, std::uint64_t const index){
+            bins_[tile].push_back(index);
+            if(++memory_count_ > memory_limit_){
+                spill();
+            }
+        }
+
+        /// \brief All indices of bin tile in the order they were added
+        std::vector<std::uint64_t> read(std::size_t const tile)const{
+            std::vector<std::uint64_t> result(count(tile));
+            if(spilled_[tile] > 0){
+                auto const file = open(tile, "rb");
+                if(std::fread(result.data(), sizeof(std::uint64_t), spilled_[tile], file.get()) != spilled_[tile]){
+                    throw std::runtime_error(fmt::format("can't read tile bin file {:s}", path(tile).string()));
+                }
+            }
+
+            std::ranges::copy(bins_[tile], result.begin() + static_cast<std::ptrdiff_t>(spilled_[tile]));
+            return result;
+        }
+
+    private:
+        struct file_close{
+            void operator()(std::FILE* const file)const noexcept{
+                std::fclose(file);
+            }
+        };
+
+        std::filesystem::path path(std::size_t const tile)const{
+            return directory_ / fmt::format("{:d}.bin", tile);
+        }
+
+        std::unique_ptr<std::FILE, file_close> open(std::size_t const tile, char const* const mode)const{
+            std::unique_ptr<std::FILE, file_close> file(std::fopen(path(tile).string().c_str(), mode));
+            if(!file){
+                throw std::runtime_error(fmt::format("can't open tile bin file {:s}", path(tile).string()));
+            }
+            return file;
+        }
+
+        /// \brief Append all bins to their files and clear them
+        void spill(){
+            if(directory_.empty()){
+                directory_ = std::filesystem::temp_directory_path() /
+                    fmt::format("ply2image-tiles-{:08x}", std::random_device{}());
+                std::filesystem::create_directories(directory_);
+            }
+
+            for(std::size_t tile = 0; tile < bins_.size(); ++tile){
+                auto& bin = bins_[tile];
+                if(bin.empty()){
+                    continue;
+                }
+
+                auto const file = open(tile, "ab");
+                if(std::fwrite(bin.data(), sizeof(std::uint64_t), bin.size(), file.get()) != bin.size()){
+                    throw std::runtime_error(fmt::format("can't write tile bin file {:s}", path(tile).string()));
+                }
+
+                spilled_[tile] += bin.size();
+                std::vector<std::uint64_t>().swap(bin);
+            }
+
+            memory_count_ = 0;
+            ++spill_count_;
+        }
+
+        std::vector<std::vector<std::uint64_t>> bins_;
+        std::vector<std::size_t> spilled_;
+        std::size_t memory_limit_;
+        std::size_t memory_count_ = 0;
+        std::size_t spill_count_ = 0;
+        std::filesystem::path directory_;
+    };
+
+
+}
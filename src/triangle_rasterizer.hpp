@@ -0,0 +1,685 @@
+#pragma once
+
+#include "raster_point.hpp"
+#include "span_kernel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Integer bounding box of a triangle clamped to the target image
+    struct pixel_box{
+        std::size_t fx;
+        std::size_t tx;
+        std::size_t fy;
+        std::size_t ty;
+
+        /// \brief Triangles whose clamped box collapses to a single row or column are not rasterized
+        bool empty()const noexcept{
+            return tx == fx || ty == fy;
+        }
+    };
+
+    inline pixel_box clamped_box(
+        double const min_x, double const max_x,
+        double const min_y, double const max_y,
+        std::size_t const width, std::size_t const height
+    ){
+        auto const clamp = [](double const v, std::size_t const size){
+                return static_cast<std::size_t>(std::clamp(static_cast<std::int64_t>(v),
+                    std::int64_t(0), static_cast<std::int64_t>(size - 1)));
+            };
+
+        return {
+            clamp(std::floor(min_x), width),
+            clamp(std::ceil(max_x), width),
+            clamp(std::floor(min_y), height),
+            clamp(std::ceil(max_y), height)};
+    }
+
+
+    /// \brief Linear edge function a * (x - x0) + b * (y - y0) of the edge opposite to a triangle vertex
+    ///
+    /// The function is evaluated relative to a point on the edge to avoid cancellation with large coordinates.
+    struct edge_function{
+        double a;
+        double b;
+        double x0;
+        double y0;
+
+        constexpr double operator()(double const x, double const y)const noexcept{
+            return a * (x - x0) + b * (y - y0);
+        }
+    };
+
+    /// \brief Edge function of the edge from j to k, it is positive left of the edge
+    constexpr edge_function make_edge_function(raster_point const& j, raster_point const& k)noexcept{
+        return {j.y - k.y, k.x - j.x, j.x, j.y};
+    }
+
+
+    /// \brief Largest count of fractional bits of the fixed-point rasterization
+    constexpr std::size_t max_subpixel_bits = 16;
+
+    /// \brief Per-pixel stage of the triangle batches of one render
+    struct raster_settings{
+        span_kernel kernel;
+
+        /// \brief Fractional bits of the fixed-point grid, 0 rasterizes in floating point
+        unsigned subpixel_bits;
+    };
+
+    /// \brief Settings with the span kernel of the instruction set and the fixed-point grid with bits fractional bits
+    ///
+    /// \throw std::runtime_error if bits exceeds max_subpixel_bits or the CPU does not support the instruction set
+    inline raster_settings make_raster_settings(simd_level const level, std::size_t const bits){
+        if(bits > max_subpixel_bits){
+            throw std::runtime_error("at most 16 subpixel bits are supported");
+        }
+        return {make_span_kernel(level), static_cast<unsigned>(bits)};
+    }
+
+    /// \brief Round the position of p to the fixed-point grid with bits fractional bits, 0 keeps it
+    inline raster_point snap_to_subpixel(raster_point p, unsigned const bits){
+        if(bits > 0){
+            auto const scale = std::ldexp(1., static_cast<int>(bits));
+            p.x = std::round(p.x * scale) / scale;
+            p.y = std::round(p.y * scale) / scale;
+        }
+        return p;
+    }
+
+
+    /// \brief Integer edge functions of a triangle with the inside positive on a fixed-point grid
+    ///
+    /// The edge function k at the pixel centre (x, y) is a[k] * x + b[k] * y + c[k]. Pixel centres on an edge
+    /// belong to the triangle only for top and left edges, so a centre on an edge shared by two triangles belongs
+    /// to exactly one of them.
+    struct fixed_edges{
+        std::array<std::int64_t, 3> a;
+        std::array<std::int64_t, 3> b;
+        std::array<std::int64_t, 3> c;
+
+        /// \brief 0 for top and left edges, 1 otherwise, a pixel is inside if all edge functions are >= bias
+        std::array<std::int64_t, 3> bias;
+
+        /// \brief Twice the area in squared grid units
+        std::int64_t area2;
+
+        std::int64_t operator()(std::size_t const k, std::int64_t const x, std::int64_t const y)const noexcept{
+            return a[k] * x + b[k] * y + c[k];
+        }
+    };
+
+
+    /// \brief Set up triangles for rasterization in structure of arrays layout
+    ///
+    /// The setup stage computes the clamped bounding box, the edge function coefficients, the reciprocal of twice
+    /// the area and copies vertex values and raster ids once per triangle. The per-pixel stage only streams from
+    /// these arrays. It runs the span kernel of its settings.
+    ///
+    /// With subpixel bits the vertices must lie on the fixed-point grid, see snap_to_subpixel. The coverage is
+    /// then decided by exact 64 bit integer edge functions with a top-left fill rule and the inside run of every
+    /// row is found without per pixel tests. Triangles with coordinates beyond the integer range fall back to
+    /// floating point.
+    class triangle_batch{
+    public:
+        explicit triangle_batch(raster_settings const& settings)noexcept
+            : kernel_(settings.kernel)
+            , subpixel_bits_(settings.subpixel_bits) {}
+
+        /// \brief Fractional bits of the fixed-point grid, 0 if the batch rasterizes in floating point
+        unsigned subpixel_bits()const noexcept{
+            return subpixel_bits_;
+        }
+
+        std::size_t size()const noexcept{
+            return rcp_area2_.size();
+        }
+
+        /// \brief Remove all triangles, the capacity is kept for the next batch
+        void clear()noexcept{
+            for(auto* list: {&fx_, &tx_, &fy_, &ty_}){
+                list->clear();
+            }
+
+            for(std::size_t k = 0; k < 3; ++k){
+                for(auto* list: {&a_[k], &b_[k], &c_[k], &y0_[k], &v_[k]}){
+                    list->clear();
+                }
+
+                for(auto* list: {&ia_[k], &ib_[k], &ic_[k], &bias_[k], &rx_[k], &ry_[k]}){
+                    list->clear();
+                }
+            }
+
+            rcp_area2_.clear();
+            kind_.clear();
+            side_.clear();
+            pixel_.clear();
+        }
+
+        /// \brief Set up a triangle
+        ///
+        /// Triangles whose clamped bounding box collapses and degenerate triangles without area are dropped.
+        ///
+        /// \return true if the triangle was added
+        bool push(std::array<raster_point, 3> const& t, std::size_t const width, std::size_t const height){
+            pixel_box box;
+            std::array<edge_function, 3> edges;
+            double area2;
+            if(!prepare(t, width, height, box, edges, area2)){
+                return false;
+            }
+
+            fixed_edges fixed{};
+            auto const use_fixed = fixed_range(t, width, height);
+            if(use_fixed && !prepare_fixed(t, fixed)){
+                return false;
+            }
+
+            fx_.push_back(box.fx);
+            tx_.push_back(box.tx);
+            fy_.push_back(box.fy);
+            ty_.push_back(box.ty);
+
+            auto const fx = static_cast<double>(box.fx);
+            for(std::size_t k = 0; k < 3; ++k){
+                a_[k].push_back(edges[k].a);
+                b_[k].push_back(edges[k].b);
+                c_[k].push_back(edges[k].a * (fx - edges[k].x0));
+                y0_[k].push_back(edges[k].y0);
+                v_[k].push_back(t[k].v);
+                rx_[k].push_back(t[k].rx);
+                ry_[k].push_back(t[k].ry);
+            }
+
+            // the integer edge functions are stored only for fixed triangles
+            if(use_fixed){
+                auto const ifx = static_cast<std::int64_t>(box.fx);
+                side_.push_back(static_cast<std::uint32_t>(ia_[0].size()));
+                for(std::size_t k = 0; k < 3; ++k){
+                    ia_[k].push_back(fixed.a[k]);
+                    ib_[k].push_back(fixed.b[k]);
+                    ic_[k].push_back(fixed.a[k] * ifx + fixed.c[k]);
+                    bias_[k].push_back(fixed.bias[k]);
+                }
+            }else{
+                side_.push_back(0);
+            }
+
+            rcp_area2_.push_back(use_fixed ? 1. / static_cast<double>(fixed.area2) : 1. / std::abs(area2));
+            kind_.push_back(use_fixed ? triangle_kind::fixed : triangle_kind::span);
+            return true;
+        }
+
+        /// \brief Set up a triangle whose bounding box contains no pixel centre but (px, py)
+        ///
+        /// The triangle is evaluated at once at the pixel with the same arithmetic as rasterize and only stored as
+        /// precomputed fragment if it covers the pixel.
+        ///
+        /// \return true if the triangle was added
+        bool push_single(
+            std::array<raster_point, 3> const& t,
+            std::size_t const px,
+            std::size_t const py,
+            std::size_t const width,
+            std::size_t const height
+        ){
+            pixel_box box;
+            std::array<edge_function, 3> edges;
+            double area2;
+            if(!prepare(t, width, height, box, edges, area2) ||
+                px < box.fx || px > box.tx || py < box.fy || py > box.ty
+            ){
+                return false;
+            }
+
+            std::array<double, 3> e;
+            if(fixed_range(t, width, height)){
+                fixed_edges fixed;
+                if(!prepare_fixed(t, fixed)){
+                    return false;
+                }
+
+                auto const x = static_cast<std::int64_t>(px);
+                auto const y = static_cast<std::int64_t>(py);
+                for(std::size_t k = 0; k < 3; ++k){
+                    auto const value = fixed(k, x, y);
+                    if(value < fixed.bias[k]){
+                        return false;
+                    }
+                    e[k] = static_cast<double>(value);
+                }
+                area2 = static_cast<double>(fixed.area2);
+            }else{
+                auto const fx = static_cast<double>(box.fx);
+                auto const fy = static_cast<double>(py);
+                auto const x = px - box.fx;
+                for(std::size_t k = 0; k < 3; ++k){
+                    e[k] = span_edge(edges[k].a * (fx - edges[k].x0) + edges[k].b * (fy - edges[k].y0),
+                        edges[k].a, x);
+                }
+
+                if(!(e[0] >= 0. && e[1] >= 0. && e[2] >= 0.)){
+                    return false;
+                }
+            }
+
+            fx_.push_back(px);
+            tx_.push_back(px);
+            fy_.push_back(py);
+            ty_.push_back(py);
+
+            // the edge function values at the pixel are kept as constant edge functions for barycentric
+            for(std::size_t k = 0; k < 3; ++k){
+                a_[k].push_back(0.);
+                b_[k].push_back(0.);
+                c_[k].push_back(e[k]);
+                y0_[k].push_back(0.);
+                v_[k].push_back(t[k].v);
+                rx_[k].push_back(t[k].rx);
+                ry_[k].push_back(t[k].ry);
+            }
+
+            auto const rcp_area2 = 1. / std::abs(area2);
+            rcp_area2_.push_back(rcp_area2);
+            kind_.push_back(triangle_kind::single);
+            side_.push_back(static_cast<std::uint32_t>(pixel_.size()));
+            pixel_.push_back(interpolate_pixel(e, rcp_area2, {{t[0].v, t[1].v, t[2].v}}));
+            return true;
+        }
+
+        /// \brief Clamped bounding box of triangle i
+        pixel_box box(std::size_t const i)const noexcept{
+            return {fx_[i], tx_[i], fy_[i], ty_[i]};
+        }
+
+        /// \brief Raster x ids of the vertices of triangle i
+        std::array<std::int64_t, 3> raster_x(std::size_t const i)const noexcept{
+            return {rx_[0][i], rx_[1][i], rx_[2][i]};
+        }
+
+        /// \brief Raster y ids of the vertices of triangle i
+        std::array<std::int64_t, 3> raster_y(std::size_t const i)const noexcept{
+            return {ry_[0][i], ry_[1][i], ry_[2][i]};
+        }
+
+        /// \brief Barycentric weights of triangle i at the covered pixel (x, y)
+        ///
+        /// The edge functions are evaluated with the same arithmetic as in rasterize, so the weights are exactly
+        /// the ones that the fragment of the pixel was interpolated with.
+        std::array<double, 3> barycentric(std::size_t const i, std::size_t const x, std::size_t const y)
+            const noexcept
+        {
+            std::array<double, 3> e;
+            if(kind_[i] == triangle_kind::fixed){
+                auto const k = static_cast<std::int64_t>(x - fx_[i]);
+                auto const iy = static_cast<std::int64_t>(y);
+                auto const f = side_[i];
+                for(std::size_t j = 0; j < 3; ++j){
+                    e[j] = static_cast<double>((ic_[j][f] + ib_[j][f] * iy) + ia_[j][f] * k);
+                }
+            }else{
+                auto const fy = static_cast<double>(y);
+                for(std::size_t j = 0; j < 3; ++j){
+                    e[j] = span_edge(c_[j][i] + b_[j][i] * (fy - y0_[j][i]), a_[j][i], x - fx_[i]);
+                }
+            }
+
+            return {{e[0] * rcp_area2_[i], e[1] * rcp_area2_[i], e[2] * rcp_area2_[i]}};
+        }
+
+        /// \brief Append triangle i of source
+        void copy_triangle(triangle_batch const& source, std::size_t const i){
+            fx_.push_back(source.fx_[i]);
+            tx_.push_back(source.tx_[i]);
+            fy_.push_back(source.fy_[i]);
+            ty_.push_back(source.ty_[i]);
+
+            for(std::size_t k = 0; k < 3; ++k){
+                a_[k].push_back(source.a_[k][i]);
+                b_[k].push_back(source.b_[k][i]);
+                c_[k].push_back(source.c_[k][i]);
+                y0_[k].push_back(source.y0_[k][i]);
+                v_[k].push_back(source.v_[k][i]);
+                rx_[k].push_back(source.rx_[k][i]);
+                ry_[k].push_back(source.ry_[k][i]);
+            }
+
+            rcp_area2_.push_back(source.rcp_area2_[i]);
+            kind_.push_back(source.kind_[i]);
+
+            auto const side = source.side_[i];
+            switch(source.kind_[i]){
+                case triangle_kind::span:
+                    side_.push_back(0);
+                    break;
+                case triangle_kind::single:
+                    side_.push_back(static_cast<std::uint32_t>(pixel_.size()));
+                    pixel_.push_back(source.pixel_[side]);
+                    break;
+                case triangle_kind::fixed:
+                    side_.push_back(static_cast<std::uint32_t>(ia_[0].size()));
+                    for(std::size_t k = 0; k < 3; ++k){
+                        ia_[k].push_back(source.ia_[k][side]);
+                        ib_[k].push_back(source.ib_[k][side]);
+                        ic_[k].push_back(source.ic_[k][side]);
+                        bias_[k].push_back(source.bias_[k][side]);
+                    }
+                    break;
+            }
+        }
+
+        /// \brief Report all pixels covered by the triangles to emit(x, y) in triangle order
+        ///
+        /// The coverage is exactly the same as with rasterize.
+        template <typename Emit>
+        void cover(Emit&& emit)const{
+            cover(std::forward<Emit>(emit), 0, size(), 0, std::numeric_limits<std::size_t>::max());
+        }
+
+        /// \brief Same as cover for the triangles [first, last) and the pixel rows [y_begin, y_end)
+        template <typename Emit>
+        void cover(
+            Emit&& emit,
+            std::size_t const first,
+            std::size_t const last,
+            std::size_t const y_begin,
+            std::size_t const y_end
+        )const{
+            traverse<false>(first, last, y_begin, y_end,
+                [this, &emit](std::size_t const i, std::size_t const y, span_range const& span){
+                    for(auto x = fx_[i] + span.first; x < fx_[i] + span.first + span.count; ++x){
+                        emit(x, y);
+                    }
+                });
+        }
+
+        /// \brief Rasterize all triangles with the span kernel
+        ///
+        /// All pixels in the clamped bounding box that lie inside or on the border of a triangle are reported to
+        /// emit(x, y, fragment) in triangle order. The barycentric weights are the edge function values times the
+        /// reciprocal of twice the area. The fragment carries the interpolated value and weight and raster id of
+        /// the dominant vertex; on equal weights the later vertex wins.
+        template <typename Emit>
+        void rasterize(Emit&& emit)const{
+            rasterize(std::forward<Emit>(emit), 0, size(), 0, std::numeric_limits<std::size_t>::max());
+        }
+
+        /// \brief Same as rasterize for the triangles [first, last) and the pixel rows [y_begin, y_end)
+        template <typename Emit>
+        void rasterize(
+            Emit&& emit,
+            std::size_t const first,
+            std::size_t const last,
+            std::size_t const y_begin,
+            std::size_t const y_end
+        )const{
+            traverse<true>(first, last, y_begin, y_end,
+                [this, &emit](std::size_t const i, std::size_t const y, span_range const& span){
+                    for(auto k = span.first; k < span.first + span.count; ++k){
+                        auto const index = fragments_.index[k];
+                        emit(fx_[i] + k, y, raw_pixel<raster_point>{
+                            fragments_.weight[k], fragments_.value[k], rx_[index][i], ry_[index][i]});
+                    }
+                });
+        }
+
+        /// \brief Same as rasterize for the triangles [first, last) and the pixel rows [y_begin, y_end), the
+        ///        index of the triangle is reported as well to emit(i, x, y, fragment)
+        template <typename Emit>
+        void rasterize_indexed(
+            Emit&& emit,
+            std::size_t const first,
+            std::size_t const last,
+            std::size_t const y_begin,
+            std::size_t const y_end
+        )const{
+            traverse<true>(first, last, y_begin, y_end,
+                [this, &emit](std::size_t const i, std::size_t const y, span_range const& span){
+                    for(auto k = span.first; k < span.first + span.count; ++k){
+                        auto const index = fragments_.index[k];
+                        emit(i, fx_[i] + k, y, raw_pixel<raster_point>{
+                            fragments_.weight[k], fragments_.value[k], rx_[index][i], ry_[index][i]});
+                    }
+                });
+        }
+
+    private:
+        /// \brief Clamped bounding box and edge functions with the inside positive and twice the area of a triangle
+        ///
+        /// \return false if the bounding box collapses or the triangle is degenerate
+        static bool prepare(
+            std::array<raster_point, 3> const& t,
+            std::size_t const width,
+            std::size_t const height,
+            pixel_box& box,
+            std::array<edge_function, 3>& edges,
+            double& area2
+        ){
+            box = clamped_box(
+                std::min({t[0].x, t[1].x, t[2].x}), std::max({t[0].x, t[1].x, t[2].x}),
+                std::min({t[0].y, t[1].y, t[2].y}), std::max({t[0].y, t[1].y, t[2].y}),
+                width, height);
+            if(box.empty()){
+                return false;
+            }
+
+            edges = {{
+                make_edge_function(t[1], t[2]),
+                make_edge_function(t[2], t[0]),
+                make_edge_function(t[0], t[1])}};
+
+            // twice the signed area, orient the edges so that the inside is positive
+            area2 = edges[0](t[0].x, t[0].y);
+            if(!(area2 != 0.)){
+                return false;
+            }
+
+            if(area2 < 0.){
+                for(auto& e: edges){
+                    e.a = -e.a;
+                    e.b = -e.b;
+                }
+            }
+
+            return true;
+        }
+
+        /// \brief Largest magnitude of a vertex coordinate or image size on the fixed-point grid
+        ///
+        /// It bounds all edge function values to 2^61, so they never overflow.
+        static constexpr double fixed_limit = double(std::int64_t(1) << 29);
+
+        /// \brief True if the batch rasterizes in fixed point and t and the image are within fixed_limit
+        bool fixed_range(std::array<raster_point, 3> const& t, std::size_t const width, std::size_t const height)
+            const noexcept
+        {
+            if(subpixel_bits_ == 0){
+                return false;
+            }
+
+            auto const scale = std::ldexp(1., static_cast<int>(subpixel_bits_));
+            auto const within = [scale](double const v){
+                    return std::abs(v * scale) <= fixed_limit;
+                };
+
+            return within(static_cast<double>(width)) && within(static_cast<double>(height)) &&
+                within(t[0].x) && within(t[0].y) && within(t[1].x) && within(t[1].y) &&
+                within(t[2].x) && within(t[2].y);
+        }
+
+        /// \brief Fixed-point edge functions with the inside positive and the top-left bias of a triangle within
+        ///        the fixed-point range
+        ///
+        /// \return false if the triangle has no area on the grid
+        bool prepare_fixed(std::array<raster_point, 3> const& t, fixed_edges& edges)const noexcept{
+            auto const scale = std::int64_t(1) << subpixel_bits_;
+            auto const fscale = static_cast<double>(scale);
+            std::array<std::int64_t, 3> x;
+            std::array<std::int64_t, 3> y;
+            for(std::size_t k = 0; k < 3; ++k){
+                x[k] = static_cast<std::int64_t>(std::round(t[k].x * fscale));
+                y[k] = static_cast<std::int64_t>(std::round(t[k].y * fscale));
+            }
+
+            // edge k runs from vertex k + 1 to vertex k + 2, edge functions in grid units
+            for(std::size_t k = 0; k < 3; ++k){
+                auto const j = (k + 1) % 3;
+                auto const l = (k + 2) % 3;
+                auto const a = y[j] - y[l];
+                auto const b = x[l] - x[j];
+                edges.a[k] = a * scale;
+                edges.b[k] = b * scale;
+                edges.c[k] = -(a * x[j] + b * y[j]);
+            }
+
+            auto const area2 = (y[1] - y[2]) * x[0] + (x[2] - x[1]) * y[0] + edges.c[0];
+            if(area2 == 0){
+                return false;
+            }
+
+            for(std::size_t k = 0; k < 3; ++k){
+                if(area2 < 0){
+                    edges.a[k] = -edges.a[k];
+                    edges.b[k] = -edges.b[k];
+                    edges.c[k] = -edges.c[k];
+                }
+
+                // the inside is right of left edges and below top edges
+                auto const top_left = edges.a[k] > 0 || (edges.a[k] == 0 && edges.b[k] > 0);
+                edges.bias[k] = top_left ? 0 : 1;
+            }
+
+            edges.area2 = area2 < 0 ? -area2 : area2;
+            return true;
+        }
+
+        /// \brief Run the span kernel over the rows of the bounding boxes of the triangles [first, last) within the
+        ///        pixel rows [y_begin, y_end) and report the inside pixels of every row to emit(i, y, span)
+        ///
+        /// The edge functions are evaluated at the start of each row and stepped incrementally along it in the
+        /// order of span_edge, so all kernels give the same result.
+        template <bool Interpolate, typename Emit>
+        void traverse(
+            std::size_t const first,
+            std::size_t const last,
+            std::size_t const y_begin,
+            std::size_t const y_end,
+            Emit&& emit
+        )const{
+            for(std::size_t i = first; i < last; ++i){
+                if(kind_[i] == triangle_kind::single){
+                    if(fy_[i] >= y_begin && fy_[i] < y_end){
+                        if constexpr(Interpolate){
+                            auto const& pixel = pixel_[side_[i]];
+                            fragments_.fit(1);
+                            fragments_.weight[0] = pixel.weight;
+                            fragments_.value[0] = pixel.value;
+                            fragments_.index[0] = pixel.index;
+                        }
+                        emit(i, fy_[i], span_range{0, 1});
+                    }
+                    continue;
+                }
+
+                auto const n = tx_[i] - fx_[i] + 1;
+                if constexpr(Interpolate){
+                    fragments_.fit(n);
+                }
+
+                if(kind_[i] == triangle_kind::fixed){
+                    auto const f = side_[i];
+                    for(auto y = std::max(fy_[i], y_begin); y <= ty_[i] && y < y_end; ++y){
+                        auto const iy = static_cast<std::int64_t>(y);
+                        fixed_span_setup const setup{
+                            {{ic_[0][f] + ib_[0][f] * iy, ic_[1][f] + ib_[1][f] * iy, ic_[2][f] + ib_[2][f] * iy}},
+                            {{ia_[0][f], ia_[1][f], ia_[2][f]}},
+                            {{bias_[0][f], bias_[1][f], bias_[2][f]}},
+                            {{v_[0][i], v_[1][i], v_[2][i]}},
+                            rcp_area2_[i],
+                            n};
+
+                        auto const span = Interpolate
+                            ? span_fixed<true>(setup, &fragments_)
+                            : span_fixed<false>(setup, nullptr);
+                        emit(i, y, span);
+                    }
+                    continue;
+                }
+
+                for(auto y = std::max(fy_[i], y_begin); y <= ty_[i] && y < y_end; ++y){
+                    auto const fy = static_cast<double>(y);
+                    span_setup const setup{
+                        {{
+                            c_[0][i] + b_[0][i] * (fy - y0_[0][i]),
+                            c_[1][i] + b_[1][i] * (fy - y0_[1][i]),
+                            c_[2][i] + b_[2][i] * (fy - y0_[2][i])}},
+                        {{a_[0][i], a_[1][i], a_[2][i]}},
+                        {{v_[0][i], v_[1][i], v_[2][i]}},
+                        rcp_area2_[i],
+                        n};
+
+                    auto const span = Interpolate
+                        ? kernel_.rasterize(setup, &fragments_)
+                        : kernel_.cover(setup, nullptr);
+                    emit(i, y, span);
+                }
+            }
+        }
+
+        /// \brief Setup path of a triangle
+        enum class triangle_kind: std::uint8_t{
+            /// \brief Rasterized with the span kernel
+            span,
+
+            /// \brief Triangle of push_single, its fragment is precomputed in pixel_[side_[i]]
+            single,
+
+            /// \brief Rasterized with the integer edge functions ia_, ib_, ic_ and bias_ at side_[i]
+            fixed
+        };
+
+        span_kernel kernel_;
+        unsigned subpixel_bits_;
+        mutable span_fragments fragments_;
+        std::vector<std::size_t> fx_;
+        std::vector<std::size_t> tx_;
+        std::vector<std::size_t> fy_;
+        std::vector<std::size_t> ty_;
+        std::array<std::vector<double>, 3> a_;
+        std::array<std::vector<double>, 3> b_;
+        std::array<std::vector<double>, 3> c_;
+        std::array<std::vector<double>, 3> y0_;
+        std::vector<double> rcp_area2_;
+        std::array<std::vector<double>, 3> v_;
+        std::array<std::vector<std::int64_t>, 3> rx_;
+        std::array<std::vector<std::int64_t>, 3> ry_;
+
+        std::vector<triangle_kind> kind_;
+
+        /// \brief Index of every triangle into the side arrays of its kind, 0 for span triangles
+        std::vector<std::uint32_t> side_;
+
+        /// \brief Side arrays of the fixed triangles
+        std::array<std::vector<std::int64_t>, 3> ia_;
+        std::array<std::vector<std::int64_t>, 3> ib_;
+        std::array<std::vector<std::int64_t>, 3> ic_;
+        std::array<std::vector<std::int64_t>, 3> bias_;
+
+        /// \brief Side array of the single triangles
+        std::vector<span_pixel> pixel_;
+    };
+
+
+}
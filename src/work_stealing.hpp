@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+namespace ply2image{
+
+
+    /// \brief Load of one worker of a work_stealing_run
+    struct worker_stats{
+        /// \brief Time spent running tasks
+        std::chrono::steady_clock::duration busy{};
+
+        /// \brief Time spent waiting for tasks
+        std::chrono::steady_clock::duration idle{};
+
+        /// \brief Count of tasks run
+        std::size_t tasks = 0;
+
+        /// \brief Count of tasks taken from other workers
+        std::size_t steals = 0;
+    };
+
+
+    /// \brief Deque of tasks owned by one worker
+    template <typename Task>
+    struct task_queue{
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+
+    /// \brief Handle of a running task to add new tasks
+    template <typename Task>
+    class task_spawner{
+    public:
+        task_spawner(
+            std::size_t const worker,
+            std::vector<task_queue<Task>>& queues,
+            std::atomic<std::size_t>& pending,
+            std::atomic<std::size_t>& signal
+        )noexcept
+            : worker_(worker)
+            , queues_(queues)
+            , pending_(pending)
+            , signal_(signal) {}
+
+        /// \brief Index of the worker that runs the task
+        std::size_t worker()const noexcept{
+            return worker_;
+        }
+
+        /// \brief Push a task onto the deque of the current worker and wake one waiting worker
+        void operator()(Task task)const{
+            ++pending_;
+            {
+                auto& queue = queues_[worker_];
+                std::lock_guard lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            ++signal_;
+            signal_.notify_one();
+        }
+
+    private:
+        std::size_t worker_;
+        std::vector<task_queue<Task>>& queues_;
+        std::atomic<std::size_t>& pending_;
+        std::atomic<std::size_t>& signal_;
+    };
+
+
+    /// \brief Run tasks on up to threads workers that steal from each other
+    ///
+    /// Every worker owns a deque of tasks. f(task, spawn) runs a task and may push new tasks onto the deque of its
+    /// worker with spawn(task). A worker takes its newest task first and steals the oldest task of another worker
+    /// when its own deque is empty, so tasks that split a range in halves hand out the biggest parts to thieves.
+    /// The initial tasks are distributed round robin. A worker that finds no task sleeps until a task is pushed or
+    /// the count of queued and running tasks drops to zero. The call returns when all tasks finished. The first
+    /// exception thrown by f is rethrown after all workers stopped, the remaining tasks are skipped.
+    ///
+    /// \return the load of every worker
+    template <typename Task, typename F>
+    std::vector<worker_stats> work_stealing_run(std::size_t const threads, std::vector<Task> initial, F const& f){
+        auto const count = std::max<std::size_t>(threads, 1);
+        std::vector<task_queue<Task>> queues(count);
+        std::vector<worker_stats> stats(count);
+
+        // count of tasks that are queued or running
+        std::atomic<std::size_t> pending{initial.size()};
+        // changes on every push, on the last finished task and on stop, idle workers wait for it to change
+        std::atomic<std::size_t> signal{0};
+        std::atomic<bool> stop{false};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        for(std::size_t i = 0; i < initial.size(); ++i){
+            queues[i % count].tasks.push_back(std::move(initial[i]));
+        }
+
+        auto const take = [&](std::size_t const worker)->std::optional<Task>{
+                {
+                    auto& queue = queues[worker];
+                    std::lock_guard lock(queue.mutex);
+                    if(!queue.tasks.empty()){
+                        auto task = std::move(queue.tasks.back());
+                        queue.tasks.pop_back();
+                        return task;
+                    }
+                }
+
+                for(std::size_t i = 1; i < count; ++i){
+                    auto& queue = queues[(worker + i) % count];
+                    std::lock_guard lock(queue.mutex);
+                    if(!queue.tasks.empty()){
+                        auto task = std::move(queue.tasks.front());
+                        queue.tasks.pop_front();
+                        ++stats[worker].steals;
+                        return task;
+                    }
+                }
+
+                return std::nullopt;
+            };
+
+        auto const worker = [&](std::size_t const index){
+                auto& own = stats[index];
+                task_spawner<Task> const spawn(index, queues, pending, signal);
+                auto idle_start = std::chrono::steady_clock::now();
+                while(!stop && pending != 0){
+                    // read before take, so a push after the failed take is not missed
+                    auto const seen = signal.load();
+                    auto task = take(index);
+                    if(!task){
+                        // stop and the last finished task are published before their signal change
+                        if(!stop && pending != 0){
+                            signal.wait(seen);
+                        }
+                        continue;
+                    }
+
+                    auto const start = std::chrono::steady_clock::now();
+                    own.idle += start - idle_start;
+                    try{
+                        f(std::move(*task), spawn);
+                    }catch(...){
+                        std::lock_guard lock(error_mutex);
+                        if(!error){
+                            error = std::current_exception();
+                        }
+                        stop = true;
+                        ++signal;
+                        signal.notify_all();
+                    }
+
+                    if(--pending == 0){
+                        ++signal;
+                        signal.notify_all();
+                    }
+
+                    idle_start = std::chrono::steady_clock::now();
+                    own.busy += idle_start - start;
+                    ++own.tasks;
+                }
+                own.idle += std::chrono::steady_clock::now() - idle_start;
+            };
+
+        {
+            std::vector<std::jthread> pool;
+            pool.reserve(count - 1);
+            for(std::size_t i = 1; i < count; ++i){
+                pool.emplace_back(worker, i);
+            }
+            worker(0);
+        }
+
+        if(error){
+            std::rethrow_exception(error);
+        }
+
+        return stats;
+    }
+
+
+}